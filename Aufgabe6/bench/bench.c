@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdint.h>
+#include "board.h"
+#include "simulator.h"
+#include "rng.h"
+#include "lockstep.h"
+#include "kernels.h"
+
+/* Benchmark harness for the snakes-and-ladders engine.
+ * Runs simulator_single_move and simulator_run_batch over a matrix of board
+ * sizes, die sizes, connection densities, exact_finish settings, engines and
+ * thread counts, and prints one JSON document with moves/sec, games/sec and
+ * ns/move per configuration, so runs of different versions can be compared.
+ */
+
+static const int bench_sides[] = {10, 100, 1000};   // board is sides x sides
+static const int bench_dice[] = {4, 6, 8};
+static const double bench_density[] = {0.0, 0.1};  // fraction of cells in a connection
+static const int bench_exact[] = {0, 1};
+
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* board with density * total_cells cells taken by snakes/ladders, placed
+ * reproducibly from seed on the cells 1 .. total_cells - 2
+ */
+static Board *bench_board(int side, int die_sides, bool exact_finish, double density, uint64_t seed) {
+    Board *b = create_board(side, side, die_sides, exact_finish);
+    if (!b) return NULL;
+
+    int inner = b->total_cells - 2;
+    int pairs = (int)(density * b->total_cells / 2);
+    if (inner > 0 && pairs > 0) {
+        int *cells = malloc(sizeof(int) * inner);
+        if (!cells) {
+            destroy_board(b);
+            return NULL;
+        }
+        for (int i = 0; i < inner; ++i) {
+            cells[i] = i + 1;
+        }
+        Rng rng;
+        rng_seed(&rng, seed);
+        for (int i = inner - 1; i > 0; --i) { // Fisher-Yates
+            int j = (int)rng_bounded(&rng, (uint32_t)i + 1);
+            int tmp = cells[i];
+            cells[i] = cells[j];
+            cells[j] = tmp;
+        }
+        for (int i = 0; i + 1 < 2 * pairs && i + 1 < inner; i += 2) {
+            board_add_connection(b, cells[i], cells[i + 1]);
+        }
+        free(cells);
+    }
+    board_build_graph(b);
+    return b;
+}
+
+// rough game length, used to size the games and the roll limit of a run
+static long bench_expected_rolls(const Board *b) {
+    return 2L * b->total_cells / (b->die_sides + 1) + 10;
+}
+
+static void print_config(const Board *b, double density) {
+    printf("\"rows\": %d, \"cols\": %d, \"die_sides\": %d, \"density\": %.2f, "
+           "\"connections\": %d, \"exact_finish\": %s",
+           b->rows, b->cols, b->die_sides, density, b->num_connections,
+           b->exact_finish ? "true" : "false");
+}
+
+// tight loop over simulator_single_move, restarting whenever a game is won
+static void bench_single_move(const Board *b, double density, long moves, bool *first) {
+    Rng rng;
+    rng_seed(&rng, 1);
+    int position = -1;
+    int last = b->total_cells - 1;
+    long sink = 0;
+
+    double t0 = now_seconds();
+    for (long i = 0; i < moves; ++i) {
+        int roll = 0, conn = -1;
+        position = simulator_single_move(b, &rng, position, &roll, &conn);
+        sink += conn;
+        if (position == last) position = -1;
+    }
+    double secs = now_seconds() - t0;
+
+    printf("%s    {\"bench\": \"single_move\", ", *first ? "" : ",\n");
+    print_config(b, density);
+    printf(", \"moves\": %ld, \"seconds\": %.6f, \"moves_per_sec\": %.1f, \"ns_per_move\": %.3f, \"checksum\": %ld}",
+           moves, secs, moves / secs, secs * 1e9 / moves, sink);
+    *first = false;
+}
+
+static void bench_run_batch(const Board *b, double density, long moves, SimEngine engine, int threads, bool *first) {
+    long expected = bench_expected_rolls(b);
+    long games = moves / expected;
+    if (games < 8L * threads) games = 8L * threads;
+    if (games > 100000000L) games = 100000000L;
+    long limit = 20 * expected;
+    if (limit > 100000000L) limit = 100000000L;
+
+    BatchOptions opt = {
+        .num_threads = threads,
+        .seed = 1,
+        .engine = engine,
+        .target_ci = 0.0,
+    };
+    // the kernel that plays the games: the lockstep SIMD path, or the scalar one picked for b
+    const char *kernel = "scalar";
+    if (engine == SIM_ENGINE_LOCKSTEP) kernel = lockstep_kernel_name();
+    else sim_kernel_pick(b, &kernel);
+
+    BatchResult res;
+    double t0 = now_seconds();
+    bool ok = simulator_run_batch(b, (int)games, (int)limit, &opt, &res);
+    double secs = now_seconds() - t0;
+
+    // every roll is a move: won games by their length, timeouts by the limit
+    long played = ok ? res.sum_rolls + (long)res.timeouts * limit : 0;
+    long played_games = ok ? res.games : 0;
+
+    printf("%s    {\"bench\": \"run_batch\", ", *first ? "" : ",\n");
+    print_config(b, density);
+    printf(", \"engine\": \"%s\", \"kernel\": \"%s\", \"threads\": %d, \"games\": %ld, \"roll_limit\": %ld, \"ok\": %s, "
+           "\"moves\": %ld, \"seconds\": %.6f, \"games_per_sec\": %.1f, \"moves_per_sec\": %.1f, \"ns_per_move\": %.3f}",
+           engine == SIM_ENGINE_LOCKSTEP ? "lockstep" : "scalar",
+           kernel, threads, played_games, limit,
+           ok ? "true" : "false", played, secs,
+           played_games / secs, played / secs, played ? secs * 1e9 / played : 0.0);
+    *first = false;
+
+    if (ok) batch_result_free(&res);
+}
+
+int main(int argc, char *argv[]) {
+    long moves = 20000000;  // moves per configuration
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) max_threads = 1;
+
+    static const struct option long_options[] = {
+        {"moves", required_argument, NULL, 'm'},
+        {"threads", required_argument, NULL, 't'},
+        {"quick", no_argument, NULL, 'q'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "m:t:q", long_options, NULL)) != -1) {
+        char *endptr;
+        errno = 0;
+        switch (opt) {
+            case 'm':
+                moves = strtol(optarg, &endptr, 10);
+                if (errno || *endptr != '\0' || moves < 1) {
+                    fprintf(stderr, "Error: --moves requires a positive integer (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 't':
+                max_threads = (int)strtol(optarg, &endptr, 10);
+                if (errno || *endptr != '\0' || max_threads < 1) {
+                    fprintf(stderr, "Error: --threads requires a positive integer (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'q':
+                moves = 2000000;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [--moves n] [--threads max] [--quick]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    // 1 thread and the maximum
+    int thread_counts[2] = {1, max_threads};
+    int num_thread_counts = max_threads > 1 ? 2 : 1;
+    SimEngine engines[2] = {SIM_ENGINE_SCALAR, SIM_ENGINE_LOCKSTEP};
+
+    printf("{\n  \"moves_per_config\": %ld,\n  \"max_threads\": %d,\n  \"results\": [\n", moves, max_threads);
+    bool first = true;
+    for (int si = 0; si < COUNT(bench_sides); ++si)
+    for (int di = 0; di < COUNT(bench_dice); ++di)
+    for (int ci = 0; ci < COUNT(bench_density); ++ci)
+    for (int ei = 0; ei < COUNT(bench_exact); ++ei) {
+        Board *b = bench_board(bench_sides[si], bench_dice[di], bench_exact[ei], bench_density[ci], 42);
+        if (!b) {
+            fprintf(stderr, "bench: board creation failed\n");
+            return EXIT_FAILURE;
+        }
+        bench_single_move(b, bench_density[ci], moves, &first);
+        for (int k = 0; k < 2; ++k) {
+            for (int ti = 0; ti < num_thread_counts; ++ti) {
+                bench_run_batch(b, bench_density[ci], moves, engines[k], thread_counts[ti], &first);
+            }
+        }
+        fflush(stdout);
+        destroy_board(b);
+    }
+    printf("\n  ]\n}\n");
+    return EXIT_SUCCESS;
+}
@@ -2,6 +2,9 @@
 #define BOARD_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
 
 /* one connection define a snake or ladder
     * start: the start point of the snake or ladder
@@ -13,23 +16,81 @@ typedef struct {
     bool is_ladder; // true if it's a ladder, false if it's a snake
 } Connection;
 
+// largest supported board: cell indices and the start row must fit an int
+#define BOARD_MAX_CELLS (INT_MAX - 1)
+// connections create_board makes room for in its block
+#define BOARD_DEFAULT_CONNECTIONS 8
+
+/* slots of the compact transition table: next state (position + 1) and
+ * connection index + 1 (0 = none)
+ */
+typedef struct {
+    uint8_t cell;
+    uint8_t conn;
+} BoardSlot8;
+
+typedef struct {
+    uint16_t cell;
+    uint16_t conn;
+} BoardSlot16;
+
+/* A board lives in one block together with cell_conn, room for
+ * conn_capacity connections and the transition table, so creating and
+ * destroying it costs one allocation each. Only a board that outgrows its
+ * connection capacity moves the connections to a separate array.
+ */
 typedef struct {
     int rows;
     int cols;
     int total_cells;
     int num_connections;
+    int conn_capacity; // entries available in connections, grows geometrically
     Connection *connections; // array of connections (snakes and ladders)
+    bool conn_external; // connections outgrew the block and were moved to the heap
+    int *cell_conn; // per cell: index of the connection starting or ending there, -1 if none
     int die_sides; // number of sides on the die
     bool exact_finish; // true if players must land exactly on the last cell to win, false otherwise
-    int **adj; // adjacency matrix for the board
+    /* transition table built by board_build_graph, (total_cells + 1) x die_sides:
+     * row 0 is the position before the board (-1), row c + 1 is cell c.
+     * next_cell holds the target after the roll with snakes/ladders already
+     * applied, next_conn the index of the traversed connection (-1 if none).
+     */
+    int *next_cell;
+    int *next_conn;
+    int *table; // storage of next_cell and next_conn in the block, used from board_build_graph on
+    /* compact copy of the table for the specialized kernels (kernels.h), for
+     * 4, 6 or 8 sided dice on boards below 65536 cells: compact_stride slots
+     * (a power of two) per state, BoardSlot8 below 256 cells, else BoardSlot16.
+     * Filled by board_build_graph.
+     */
+    void *compact;
+    int compact_width; // bytes per slot field: 1, 2, or 0 without a compact table
+    int compact_stride;
 } Board;
 
 Board *create_board(int rows, int cols, int die_sides, bool exact_finish);
+// like create_board with room for conn_capacity connections in the block
+Board *create_board_reserved(int rows, int cols, int die_sides, bool exact_finish, int conn_capacity);
 void destroy_board(Board *board);
 
 bool board_add_connection(Board *board, int start, int end);
+// makes room for capacity connections up front (e.g. when loading a board file)
+bool board_reserve_connections(Board *board, int capacity);
 void board_print(const Board *board);
 int board_move(const Board *board, int position, int roll);
 void board_build_graph(Board *b);
 
+/* Fewest rolls needed to win: breadth-first search over the transition table,
+ * O(total_cells * die_sides), honouring exact_finish and snakes/ladders.
+ * Returns the number of rolls, or -1 if the last cell can not be reached.
+ * If path is not NULL it receives a malloc'd optimal roll sequence of that
+ * length (the caller frees it).
+ */
+int board_shortest_path(const Board *b, int **path);
+
+// slot of (position, roll) in next_cell / next_conn, position -1 .. total_cells-1
+static inline size_t board_move_index(const Board *b, int position, int roll) {
+    return (size_t)(position + 1) * (size_t)b->die_sides + (size_t)(roll - 1);
+}
+
 #endif // BOARD_H
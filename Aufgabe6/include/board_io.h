@@ -0,0 +1,65 @@
+#ifndef BOARD_IO_H
+#define BOARD_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "board.h"
+
+/* Board definition files, one file may hold any number of boards.
+ *
+ * Text form, '#' starts a comment:
+ *     board <rows> <cols> <die_sides> <exact_finish 0|1>
+ *     <start> <end>        one line per snake or ladder
+ *     board ...            the next board
+ *
+ * Binary form (native byte order), meant to be memory-mapped:
+ *     BoardFileHeader, then count BoardRecord entries, then the
+ *     connections of every board as int32 start/end pairs at conn_offset.
+ */
+#define BOARD_FILE_MAGIC "SLBOARD1"
+#define BOARD_FILE_VERSION 1
+
+typedef struct {
+    char magic[8];          // BOARD_FILE_MAGIC without terminator
+    uint32_t version;
+    uint32_t count;         // number of boards
+} BoardFileHeader;
+
+typedef struct {
+    int32_t rows;
+    int32_t cols;
+    int32_t die_sides;
+    int32_t exact_finish;
+    int32_t num_connections;
+    int32_t reserved;
+    uint64_t conn_offset;   // file offset of num_connections start/end pairs
+} BoardRecord;
+
+/* Read-only mapping of a binary board file, boards are built on demand */
+typedef struct {
+    void *map;
+    size_t size;
+    uint32_t count;
+    const BoardRecord *records;
+} BoardPack;
+
+// maps path and checks header and record bounds; false with a message on error
+bool board_pack_open(const char *path, BoardPack *pack);
+// builds board index of the pack (without the transition table), NULL on error
+Board *board_pack_get(const BoardPack *pack, uint32_t index);
+void board_pack_close(BoardPack *pack);
+
+/* All boards of a text or binary file (detected by the magic) */
+typedef struct {
+    Board **boards;
+    int count;
+} BoardSet;
+
+bool board_file_load(const char *path, BoardSet *set);
+void board_set_free(BoardSet *set);
+
+bool board_file_save_binary(const char *path, Board *const *boards, int count);
+bool board_file_save_text(const char *path, Board *const *boards, int count);
+
+#endif // BOARD_IO_H
@@ -0,0 +1,69 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "simulator.h"
+
+/* Checkpoints of simulator_run_batch, taken at round boundaries: the blocks
+ * merged so far and the merged BatchResult. Every block has its own stream
+ * (see simulator.h), so a run resumed from a checkpoint plays the remaining
+ * rounds exactly as the original run would have, with any number of
+ * threads, and ends with the same result.
+ *
+ * File layout (native byte order): CheckpointHeader, then the merged result
+ * (see result_io.h).
+ * Files are written to path.tmp and renamed, so a crash while writing
+ * leaves the previous checkpoint intact.
+ */
+#define CHECKPOINT_MAGIC "SLCKPT01"
+#define CHECKPOINT_VERSION 3
+
+/* Everything that decides how the games of a run are played; a checkpoint
+ * is only resumed by a run with the same key
+ */
+typedef struct {
+    uint64_t seed;
+    uint64_t board_hash;   // checkpoint_board_hash
+    int32_t num_games;
+    int32_t max_steps;
+    int32_t block_games;   // simulator_block_games(num_games)
+    int32_t engine;
+    int32_t checkpoint_every;
+    int32_t shard_index;   // see BatchOptions
+    int32_t shard_count;
+    int32_t reserved;
+    double target_ci;
+} CheckpointKey;
+
+/* State at a round boundary */
+typedef struct {
+    CheckpointKey key;
+    int played;            // blocks of the shard merged into result
+    int round;             // blocks of the next round
+    BatchResult result;
+} CheckpointState;
+
+// hash of the dimensions, rules and connections of b
+uint64_t checkpoint_board_hash(const Board *b);
+
+/* Loads path into out (result initialised; release with
+ * checkpoint_state_free). Fails with a message if the file is damaged or was
+ * written by a run with a different key.
+ */
+bool checkpoint_load(const char *path, const CheckpointKey *key, int num_connections, CheckpointState *out);
+void checkpoint_state_free(CheckpointState *state);
+
+/* Background writer: checkpoint_writer_submit serializes the state right
+ * away (the caller may change it afterwards) and writes it on a separate
+ * thread; a submit first waits for the previous write to finish.
+ */
+typedef struct CheckpointWriter CheckpointWriter;
+
+CheckpointWriter *checkpoint_writer_create(const char *path);
+bool checkpoint_writer_submit(CheckpointWriter *w, const CheckpointState *state, int num_connections);
+// waits for the last write; false if any write failed
+bool checkpoint_writer_finish(CheckpointWriter *w);
+
+#endif // CHECKPOINT_H
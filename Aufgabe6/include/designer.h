@@ -0,0 +1,47 @@
+#ifndef DESIGNER_H
+#define DESIGNER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Board designer: searches placements of a fixed number of snakes and
+ * ladders (following the rules of board_add_connection) whose exact game
+ * length is close to a target mean and standard deviation.
+ *
+ * Every chain runs simulated annealing; a step moves one end of one
+ * connection and re-solves E[T] and Var[T] with markov_moments, warm-started
+ * from the current board, so a candidate costs a few sweeps instead of a
+ * Monte Carlo batch. Chain c runs on its own thread with the seed stream
+ * long-jumped c times; the best chain wins (lower index on ties), so a spec
+ * always produces the same board.
+ */
+typedef struct {
+    int rows;
+    int cols;
+    int die_sides;
+    bool exact_finish;
+    int num_connections;   // snakes and ladders to place
+    double target_mean;    // rolls
+    double target_stddev;  // rolls, <= 0 to only match the mean
+    int iterations;        // annealing steps per chain
+    int num_chains;        // chains run in parallel, one thread each
+    uint64_t seed;
+} DesignSpec;
+
+typedef struct {
+    int (*pairs)[2];       // num_pairs start/end pairs, as for -s
+    int num_pairs;
+    double mean;
+    double variance;
+    double cost;           // squared relative error of mean (and stddev)
+    long evaluations;      // candidates solved over all chains
+} DesignResult;
+
+/* Runs the search; out->pairs is malloc'd (release with design_result_free).
+ * Returns false if the connections do not fit the board, no chain found a
+ * board that can always be won, or on allocation failure.
+ */
+bool designer_run(const DesignSpec *spec, DesignResult *out);
+void design_result_free(DesignResult *res);
+
+#endif // DESIGNER_H
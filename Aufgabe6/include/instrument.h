@@ -0,0 +1,53 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdio.h>
+
+/* Optional hot-path counters, compiled in with -DSL_INSTRUMENT
+ * (make INSTRUMENT=1). Every thread counts into its own thread-local
+ * InstrCounters and adds them to the process totals with instr_flush when
+ * it finishes; instr_report prints the totals (-v). Without SL_INSTRUMENT
+ * the macros expand to nothing, so the default build pays nothing.
+ */
+#ifdef SL_INSTRUMENT
+
+#include <time.h>
+
+typedef struct {
+    long moves;          // die rolls played
+    long conn_hits;      // snakes and ladders taken, timed-out games included
+    long bounces;        // exact-finish overshoots that left the player in place (scalar engines)
+    long timeouts;       // games that reached the roll or round limit
+    long allocs;         // malloc/calloc/realloc calls of boards and results
+    double play_sec;     // time spent playing games, summed over threads
+    double aggregate_sec; // time spent merging results
+} InstrCounters;
+
+extern _Thread_local InstrCounters instr_local;
+
+static inline double instr_seconds_since(const struct timespec *t0) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+#define INSTR_ADD(counter, n) (instr_local.counter += (n))
+#define INSTR_CLOCK(name) struct timespec name; clock_gettime(CLOCK_MONOTONIC, &name)
+#define INSTR_ELAPSED(counter, since) (instr_local.counter += instr_seconds_since(&(since)))
+
+// adds the counters of the calling thread to the totals and clears them
+void instr_flush(void);
+
+#else
+
+#define INSTR_ADD(counter, n) ((void)0)
+#define INSTR_CLOCK(name) ((void)0)
+#define INSTR_ELAPSED(counter, since) ((void)0)
+#define instr_flush() ((void)0)
+
+#endif // SL_INSTRUMENT
+
+// prints the totals, or a note if the counters were not compiled in
+void instr_report(FILE *out);
+
+#endif // INSTRUMENT_H
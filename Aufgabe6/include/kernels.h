@@ -0,0 +1,25 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "board.h"
+#include "rng.h"
+
+/* Specialized game kernels for the scalar engine.
+ *
+ * For 4, 6 and 8 sided dice a kernel is generated per die size and slot
+ * type of the compact table (see Board::compact): the die size is a
+ * compile-time constant, so the bounded roll folds to a multiply and shift
+ * (no rejection test at all for 4 and 8), rows have a power-of-two stride
+ * and a 10x10 board with a d6 takes 1.6 KB (101 rows of 8 two-byte slots)
+ * instead of 4.8 KB of int tables (101 x 6 x 2 ints).
+ * They draw exactly what simulator_play_counted draws and return the same
+ * results; other boards use simulator_play_counted itself.
+ */
+
+// same contract as simulator_play_counted
+typedef int (*SimKernel)(const Board *b, Rng *rng, int max_steps, long *conn_counts, int *conn_hits);
+
+// kernel for b (after board_build_graph); name receives e.g. "d6/u8" or "generic"
+SimKernel sim_kernel_pick(const Board *b, const char **name);
+
+#endif // KERNELS_H
@@ -0,0 +1,29 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <stdbool.h>
+#include "board.h"
+#include "rng.h"
+#include "simulator.h"
+
+/* Lockstep engine: LOCKSTEP_LANES games are kept in structure-of-arrays
+ * form (position, roll count and an own xoshiro256** stream per lane) and
+ * advanced together, one roll per lane and step. A lane whose game ends is
+ * refilled with the next game of the range.
+ *
+ * The step kernel is picked at runtime: AVX-512, AVX2 (gathers from the
+ * transition table) or a portable scalar loop. All three produce the same
+ * rolls for the same lane streams, so the results do not depend on the CPU.
+ * Lane streams are rng_split from the worker stream. The fastest game is not
+ * recorded while playing; its roll sequence is replayed from the lane state
+ * saved when the game started.
+ */
+#define LOCKSTEP_LANES 8
+
+// Same contract as simulator_play_range
+bool lockstep_play_range(const Board *b, Rng *rng, int first_game, int num_games, int max_steps, BatchResult *res, TraceSink *trace);
+
+// name of the step kernel lockstep_play_range uses on this CPU
+const char *lockstep_kernel_name(void);
+
+#endif // LOCKSTEP_H
@@ -0,0 +1,48 @@
+#ifndef MARKOV_H
+#define MARKOV_H
+
+#include <stdbool.h>
+#include "board.h"
+
+/* Exact solution of the game as an absorbing Markov chain.
+ * States are "before the board" plus every cell, the last cell absorbs;
+ * every roll has probability 1 / die_sides.
+ */
+typedef struct {
+    double expected_rolls;       // E[T], T = rolls until the last cell is reached
+    double variance;             // Var[T]
+    double win_probability;      // P(T <= roll_limit)
+    double expected_within_limit; // E[T | T <= roll_limit], comparable to the simulated average
+    int iterations;              // Gauss-Seidel sweeps needed for E[T] and E[T^2]
+    int non_terminating;         // cells the player never gets to that do not lead to the last cell for sure
+} MarkovResult;
+
+/* Solves the board exactly:
+ *  - E[T] and E[T^2] with Gauss-Seidel sweeps over t = 1 + Q t,
+ *    processed from the last cell backwards (converges in a few sweeps
+ *    for boards with few snakes)
+ *  - P(T <= roll_limit) by pushing the state distribution roll_limit times
+ *
+ * Needs board_build_graph to have been called.
+ * Cells from which the last cell is not reached with probability 1 are left
+ * out of the sweeps and counted in non_terminating; returns false if the
+ * player can get to such a cell from the start (E[T] infinite), if the
+ * sweeps do not converge or on allocation failure.
+ */
+bool markov_solve(const Board *b, int roll_limit, MarkovResult *out);
+
+/* E[T] and Var[T] of a board given only by its jumps, without building a
+ * transition table; meant for evaluating many candidate boards (designer.h).
+ *  - jump[c]: cell a player landing on c ends up on (c if no connection)
+ *  - t, m2: total_cells + 1 values each (state 0 = before the board, c + 1 =
+ *      cell c); their contents on entry are the starting guess, so passing
+ *      the solution of a similar board converges in a few sweeps
+ *  - max_sweeps, limit: the solve gives up silently after max_sweeps sweeps
+ *      or once a value exceeds limit, which also rejects boards where the
+ *      last cell can not be reached from every position
+ */
+bool markov_moments(int total_cells, int die_sides, bool exact_finish, const int *jump,
+                    int max_sweeps, double limit, double *t, double *m2,
+                    double *mean, double *variance);
+
+#endif // MARKOV_H
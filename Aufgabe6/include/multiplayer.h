@@ -0,0 +1,48 @@
+#ifndef MULTIPLAYER_H
+#define MULTIPLAYER_H
+
+#include <stdbool.h>
+#include "board.h"
+#include "rng.h"
+#include "simulator.h"
+
+/* Games of num_players players taking turns in seat order (seat 0 first).
+ * The first player to reach the last cell wins; a game times out after
+ * max_rounds rounds. All positions of a game live in one small array and
+ * every round moves all players through the shared transition table before
+ * looking for a winner; a winner is the lowest seat that reached the last
+ * cell that round, so later seats moving in the same round changes nothing.
+ */
+typedef struct {
+    int num_players;
+    int games;         // games played, won or timed out
+    int timeouts;      // games without a winner after max_rounds rounds
+    long *seat_wins;   // per seat
+    int max_rounds;    // round_hist has max_rounds + 1 entries
+    long *round_hist;  // round_hist[r]: games won in round r
+} MultiResult;
+
+// empty result with zeroed counters; false on allocation failure
+bool multi_result_init(MultiResult *res, int num_players, int max_rounds);
+void multi_result_free(MultiResult *res);
+bool multi_result_merge(MultiResult *into, const MultiResult *from);
+
+/* Game length in rounds of the won games (see BatchSummary) */
+void multi_result_summary(const MultiResult *res, BatchSummary *out);
+
+/* Plays one game with positions as scratch space (num_players entries).
+ * Returns the winning seat and its round in *rounds, or -1 on timeout.
+ * Needs the transition table from board_build_graph.
+ */
+int multi_play_game(const Board *b, Rng *rng, int num_players, int max_rounds, int *positions, int *rounds);
+
+/* Like simulator_run_batch for k-player games: the games are played in
+ * blocks with one stream each (see simulator.h), num_threads workers play
+ * contiguous shares of the blocks, so the result does not depend on the
+ * number of threads. opt->engine and opt->target_ci are not used.
+ * Returns false on invalid arguments or allocation failure.
+ */
+bool multi_run_batch(const Board *b, int num_games, int num_players, int max_rounds,
+                     const BatchOptions *opt, MultiResult *out);
+
+#endif // MULTIPLAYER_H
@@ -0,0 +1,32 @@
+#ifndef RESULT_IO_H
+#define RESULT_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "simulator.h"
+
+/* Serialized BatchResult, shared by checkpoint and shard files (native
+ * byte order): the counters as int64, best_len path entries as int32, then
+ * num_connections connection counts and max_steps + 1 histogram bins as int64.
+ */
+
+size_t result_io_size(const BatchResult *res, int num_connections);
+// writes res at p, returns the end of the written bytes
+char *result_io_put(char *p, const BatchResult *res, int num_connections);
+
+/* Reads a result for max_steps at *pos of buf (size bytes) into out, which
+ * is initialised here; false (out released) if the bytes run out or are invalid
+ */
+bool result_io_get(const char *buf, size_t size, size_t *pos, int num_connections, int max_steps, BatchResult *out);
+
+// bytes at *pos, false past the end of buf
+bool result_io_take(const char *buf, size_t size, size_t *pos, void *data, size_t len);
+
+/* Whole files: result_io_read_file returns a malloc'd copy of path (NULL
+ * with a message on error); result_io_write_file writes path.tmp and renames
+ * it, so a crash never leaves a half-written path behind.
+ */
+char *result_io_read_file(const char *path, size_t *size);
+bool result_io_write_file(const char *path, const char *buf, size_t size);
+
+#endif // RESULT_IO_H
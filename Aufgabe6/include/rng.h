@@ -0,0 +1,64 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/* xoshiro256** generator with explicit state.
+ * Every thread or stream owns one Rng, nothing is shared globally,
+ * so a run is reproducible from its seed alone.
+ */
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+// initialise the state from a 64-bit seed (expanded with splitmix64)
+void rng_seed(Rng *r, uint64_t seed);
+
+// advance the state by 2^128 steps: successive jumps give non-overlapping streams
+void rng_jump(Rng *r);
+
+// advance the state by 2^192 steps: used to separate groups of streams
+void rng_long_jump(Rng *r);
+
+/* Hands out an independent stream: child gets the current state of
+ * parent, parent jumps ahead 2^128 steps for the next call.
+ */
+void rng_split(Rng *parent, Rng *child);
+
+static inline uint64_t rng_rotl(const uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// next 64 random bits
+static inline uint64_t rng_next(Rng *r) {
+    uint64_t *s = r->s;
+    const uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+
+    return result;
+}
+
+/* Unbiased integer in [0, n) for n >= 1 (Lemire's multiply-and-reject):
+ * the rejection branch is taken with probability < n / 2^32.
+ */
+static inline uint32_t rng_bounded(Rng *r, uint32_t n) {
+    uint64_t m = (rng_next(r) >> 32) * (uint64_t)n;
+    uint32_t low = (uint32_t)m;
+    if (low < n) {
+        uint32_t threshold = -n % n;
+        while (low < threshold) {
+            m = (rng_next(r) >> 32) * (uint64_t)n;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+#endif // RNG_H
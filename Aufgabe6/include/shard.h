@@ -0,0 +1,42 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "simulator.h"
+
+/* Result shards (--shard i/N, --shard-out file): every process plays one
+ * shard of a run (see BatchOptions) and saves its BatchResult together with
+ * the board and the options; `merge` adds the shards up into the result of
+ * the whole run, wherever and with however many threads they were played.
+ *
+ * File layout (native byte order): ShardHeader, num_connections
+ * start/end pairs (int32), then the result (see result_io.h).
+ */
+#define SHARD_MAGIC "SLSHARD1"
+#define SHARD_VERSION 2
+
+// the run a shard belongs to
+typedef struct {
+    int shard_index;
+    int shard_count;
+    int num_games;     // of all shards together
+    int max_steps;
+    int engine;        // SimEngine
+    uint64_t seed;
+} ShardInfo;
+
+// writes the result of one shard played on b; false with a message on error
+bool shard_save(const char *path, const ShardInfo *info, const Board *b, const BatchResult *res);
+
+/* Loads count shard files of the same run and merges them:
+ *  - info: the run (shard_index is -1)
+ *  - board: the board of the run, rebuilt from the files (destroy_board)
+ *  - out: merged result, released with batch_result_free
+ * Files of different runs, the same shard twice or damaged files fail with
+ * a message. Missing shards only leave their games out of the result.
+ */
+bool shard_merge(const char *const *paths, int count, ShardInfo *info, Board **board, BatchResult *out);
+
+#endif // SHARD_H
@@ -2,15 +2,20 @@
 #define SIMULATOR_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "board.h"
+#include "rng.h"
+#include "trace.h"
 
 /* Executes a single move for a player:
+  rng: random stream of the calling thread (see roll_die)
   position: current square (0-based, -1 = before entering the board)
+  Needs the transition table from board_build_graph.
   Rolls the die and moves the player, returning the new position.
   Also returns via pointer (traversed_connection_index) the index
   of the connection used (-1 if none).
  */
-int simulator_single_move(const Board *b, int position, int *roll_out, int *traversed_connection_index);
+int simulator_single_move(const Board *b, Rng *rng, int position, int *roll_out, int *traversed_connection_index);
 
 /* Simulates a single game and provides:
    - total_rolls: total number of die rolls until victory
@@ -22,27 +27,152 @@ int simulator_single_move(const Board *b, int position, int *roll_out, int *trav
  
   Returns true if the game is won within max_steps, false on timeout.
  */
-bool simulator_play_single_game(const Board *b, int max_steps, int *total_rolls, int *path, int path_capacity, int *path_len, int *conn_path);
+bool simulator_play_single_game(const Board *b, Rng *rng, int max_steps, int *total_rolls, int *path, int path_capacity, int *path_len, int *conn_path);
 
+/* Plays a single game without recording it: every traversed connection is
+ * added to conn_counts (one entry per connection) as it happens, and their
+ * number is stored in *conn_hits.
+ * Returns the number of rolls if the game is won within max_steps, 0 on timeout.
+ */
+int simulator_play_counted(const Board *b, Rng *rng, int max_steps, long *conn_counts, int *conn_hits);
+
+/* Replays the game that started with random state start for max_steps rolls
+ * and takes its connections back out of conn_counts (used for timeouts,
+ * the counts only cover won games).
+ */
+void simulator_uncount_game(const Board *b, const Rng *start, int max_steps, long *conn_counts);
+
+/* Aggregate of a range of games, mergeable across workers.
+ * conn_counts has one entry per connection and only counts won games,
+ * best_path is the roll sequence of the fastest win (lowest game index on ties).
+ * hist[r] counts the games won with exactly r rolls (r = 0 .. max_steps),
+ * so the distribution is kept in O(max_steps) memory however many games run.
+ */
+typedef struct {
+    int games;         // games played, won or timed out
+    int wins;
+    int timeouts;      // games that reached max_steps without winning
+    long sum_rolls;
+    int best_rolls;    // INT_MAX while nothing was won
+    int best_game;     // -1 while nothing was won
+    int *best_path;
+    int best_len;
+    long *conn_counts;
+    int max_steps;     // hist has max_steps + 1 entries
+    long *hist;
+} BatchResult;
+
+// empty result with zeroed counters; false on allocation failure
+bool batch_result_init(BatchResult *res, int num_connections, int max_steps);
+void batch_result_free(BatchResult *res);
+
+/* Adds from to into (both initialised for the same board and max_steps).
+ * The best game of from replaces the one of into if it is faster, or as
+ * fast with a lower game index. Returns false on allocation failure.
+ */
+bool batch_result_merge(BatchResult *into, const BatchResult *from, int num_connections);
+
+/* Distribution of the rolls of the won games, computed from hist */
+typedef struct {
+    double mean;
+    double variance;   // sample variance
+    double ci95;       // half-width of the 95% confidence interval of the mean
+    int p50;           // percentiles of the game length
+    int p95;
+    int p99;
+} BatchSummary;
+
+void batch_result_summary(const BatchResult *res, BatchSummary *out);
+
+/* Re-simulates the winning game that started with random state start and
+ * stores its roll sequence (res->best_rolls rolls) as res->best_path.
+ * Returns false on allocation failure.
+ */
+bool simulator_replay_best(const Board *b, const Rng *start, BatchResult *res);
+
+/* Engines for playing a range of games:
+ *  - SIM_ENGINE_SCALAR plays one game after the other
+ *  - SIM_ENGINE_LOCKSTEP advances several games side by side (see lockstep.h)
+ */
+typedef enum {
+    SIM_ENGINE_SCALAR,
+    SIM_ENGINE_LOCKSTEP
+} SimEngine;
+
+/* Plays games [first_game, first_game + num_games) one by one on rng and
+ * adds them to res (initialised with batch_result_init for max_steps).
+ * Connections are counted while playing and only the random state at the
+ * start of each game is kept; the fastest game is replayed once at the end.
+ * Games run on the specialized kernel for the board if there is one (kernels.h).
+ * If trace is not NULL every game is also recorded there.
+ * Returns false on allocation failure.
+ */
+bool simulator_play_range(const Board *b, Rng *rng, int first_game, int num_games, int max_steps, BatchResult *res, TraceSink *trace);
+
+/* Games of a batch are played in blocks of simulator_block_games(num_games)
+ * games: SIM_BLOCK_GAMES, or fewer so that a small batch still has about
+ * SIM_MIN_BLOCKS blocks to spread over threads and shards. Block k holds
+ * games [k * block_games, (k + 1) * block_games) and plays them on the seed
+ * stream long-jumped k times (rng_long_jump), whoever plays it.
+ */
+#define SIM_BLOCK_GAMES 1024
+#define SIM_MIN_BLOCKS 64
+
+int simulator_block_games(int num_games);
+
+/* How simulator_run_batch plays its games:
+ *  - num_threads: number of worker threads; every worker plays its own
+ *      contiguous share of the blocks with private buffers and counters.
+ *      The streams belong to the blocks, so the result does not depend
+ *      on the number of threads
+ *  - seed: base seed of the block streams, which are 2^192 steps apart so
+ *      they never overlap even when an engine splits them further
+ *  - engine: how each block is played (see SimEngine)
+ *  - target_ci: if > 0, blocks are played in rounds that double the games
+ *      played so far, and the batch stops once the 95% confidence interval
+ *      of the mean is at most +-target_ci rolls (num_games is then the maximum)
+ *  - trace: if not NULL, worker t records every game in sink t (opened
+ *      with at least num_threads producers)
+ *  - checkpoint_path: if not NULL, the state after every round is written
+ *      there in the background (see checkpoint.h); without target_ci the
+ *      rounds are checkpoint_every games long, rounded up to whole blocks
+ *      (0 = a single round)
+ *  - resume: continue from the checkpoint at checkpoint_path, which must
+ *      come from a run with the same board and options (-t may differ)
+ *  - shard_index, shard_count: play only shard shard_index of shard_count
+ *      (0 = no shards) of the K blocks of the run, i.e. blocks
+ *      [i * K / N, (i + 1) * K / N). The shards play exactly the blocks of
+ *      the unsharded run, so their merged results (see shard.h) equal it
+ *      whatever -t every shard ran with. Game indices stay global, so the
+ *      fastest game is the same whichever process played it.
+ */
+typedef struct {
+    int num_threads;
+    uint64_t seed;
+    SimEngine engine;
+    double target_ci;
+    TraceWriter *trace;
+    const char *checkpoint_path;
+    int checkpoint_every;
+    bool resume;
+    int shard_index;
+    int shard_count;
+} BatchOptions;
 
 /**
  * Runs a batch of simulations and gathers aggregate statistics:
- *  - num_games: number of games to simulate
+ *  - num_games: number of games to simulate (of all shards together)
  *  - max_steps: maximum rolls per game before timeout
- *  - avg_rolls: output parameter for the average rolls until victory
- *  - min_rolls: output parameter for the minimum rolls needed in any win
- *  - best_path: output pointer to an array holding the roll sequence of the shortest game
- *  - best_path_len: output parameter for the length of best_path
- *  - connection_counts: output pointer to an array of length b->num_connections,
- *      where each entry counts how often that connection was traversed
+ *  - opt: threads, seed, engine and stopping rule (see BatchOptions)
+ *  - out: merged result of all workers, initialised by this function;
+ *      the caller releases it with batch_result_free
  *
- * Memory for best_path and connection_counts is allocated by this function;
- * the caller is responsible for freeing both.
+ * The per-worker results are merged in worker order (ties for the fastest
+ * game go to the lower game index), so the same options always produce
+ * the same output.
  *
  * Returns true if at least one game was won, false otherwise.
  */
-bool simulator_run_batch(const Board *b, int num_games, int max_steps, double *avg_rolls, int *min_rolls, int **best_path, int *best_path_len,int *best_game_index, long **connection_counts);
-
-
+bool simulator_run_batch(const Board *b, int num_games, int max_steps, const BatchOptions *opt, BatchResult *out);
 
 #endif // SIMULATOR_H
@@ -0,0 +1,60 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "simulator.h"
+
+/* Parameter sweep: one connection set evaluated over ranges of board
+ * dimensions, die sizes and exact_finish settings in a single process.
+ *
+ * Every configuration is split into jobs of at most SWEEP_CHUNK_GAMES games
+ * and all jobs of all configurations are handed out to one pool of worker
+ * threads, so small configurations do not leave cores idle. Job j plays on
+ * the seed stream long-jumped j times, and the jobs of a configuration are
+ * merged in order: the table only depends on the spec, not on the number of
+ * threads or the scheduling. The board of a configuration is built by the
+ * first of its jobs that runs and freed after the last one, so only the
+ * configurations in play hold a board, however large the ranges are.
+ */
+#define SWEEP_CHUNK_GAMES 65536
+
+typedef struct {
+    int first;
+    int last;   // inclusive
+    int step;   // >= 1
+} SweepRange;
+
+typedef struct {
+    SweepRange rows;
+    SweepRange cols;
+    SweepRange die_sides;
+    SweepRange exact_finish;    // within 0 .. 1
+    const int (*pairs)[2];      // connection set shared by all configurations
+    int num_pairs;
+    int num_games;
+    int max_steps;
+    int num_threads;
+    uint64_t seed;
+    SimEngine engine;
+} SweepSpec;
+
+/* One configuration of the sweep */
+typedef struct {
+    int rows;
+    int cols;
+    int die_sides;
+    bool exact_finish;
+    bool valid;         // false if the connection set does not fit this board
+    BatchResult result; // only set if valid
+} SweepRow;
+
+/* Runs every configuration of spec (rows, then cols, die_sides, exact_finish
+ * in ascending order). *rows_out receives count entries; release them with
+ * sweep_free. Returns false on an empty range or allocation failure (the
+ * latter with a message).
+ */
+bool sweep_run(const SweepSpec *spec, SweepRow **rows_out, int *count);
+void sweep_free(SweepRow *rows, int count);
+
+#endif // SWEEP_H
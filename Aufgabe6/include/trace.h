@@ -0,0 +1,89 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rng.h"
+
+/* Per-game trace (--trace): one record per game, streamed to a file by a
+ * background writer thread.
+ *
+ * Every producer (batch worker) fills its own pair of large buffers; a full
+ * buffer is handed to the writer and the producer continues in the other
+ * one, so workers only wait if the disk falls a whole buffer behind.
+ * Records of different workers are interleaved buffer by buffer, the
+ * board and game index identify them.
+ *
+ * Every record keeps the random state the game started with: playing the
+ * board from it (simulator_play_counted with the max_steps of the header)
+ * replays the game roll by roll. The state lies in the stream of block
+ * game / simulator_block_games(n) of the run (see simulator.h).
+ *
+ * Binary layout: TraceFileHeader, then TraceRecord entries (little endian
+ * on the usual platforms, native byte order). CSV layout: a header line,
+ * then board,game,won,rolls,conn_hits,rng0,rng1,rng2,rng3 per line.
+ */
+#define TRACE_MAGIC "SLTRACE1"
+#define TRACE_VERSION 2
+#define TRACE_BUFFER_RECORDS 65536
+
+typedef enum {
+    TRACE_BINARY,
+    TRACE_CSV
+} TraceFormat;
+
+typedef struct {
+    char magic[8];          // TRACE_MAGIC, not terminated
+    uint32_t version;
+    uint32_t record_size;   // sizeof(TraceRecord)
+    uint32_t max_steps;     // roll limit of the run
+    uint32_t reserved;
+    uint64_t seed;
+} TraceFileHeader;
+
+typedef struct {
+    uint32_t board;         // index in the board set, 0 for -w/-h boards
+    uint32_t game;          // game index within the batch
+    uint32_t rolls;         // rolls to win, 0 if the game timed out after max_steps
+    uint32_t conn_hits;     // snakes and ladders taken
+    uint64_t start[4];      // Rng state at the start of the game
+} TraceRecord;
+
+typedef struct TraceWriter TraceWriter;
+
+/* Buffers of one producer; only its own worker touches buf[cur] */
+typedef struct {
+    TraceWriter *writer;
+    TraceRecord *buf[2];
+    int cur;
+    int fill;
+    bool busy[2];           // handed to the writer, guarded by the writer lock
+    uint32_t board;
+} TraceSink;
+
+// hands the full current buffer to the writer and switches buffers
+void trace_submit(TraceSink *s);
+
+static inline void trace_record(TraceSink *s, int game, int rolls, int conn_hits, const Rng *start) {
+    s->buf[s->cur][s->fill++] = (TraceRecord){s->board, (uint32_t)game, (uint32_t)rolls, (uint32_t)conn_hits,
+                                              {start->s[0], start->s[1], start->s[2], start->s[3]}};
+    if (s->fill == TRACE_BUFFER_RECORDS) trace_submit(s);
+}
+
+/* Creates path and starts the writer thread (records are written on the
+ * calling thread if it can not be started). NULL on error.
+ */
+TraceWriter *trace_open(const char *path, TraceFormat format, int num_producers, int max_steps, uint64_t seed);
+
+// sink of producer i (0 .. num_producers - 1)
+TraceSink *trace_sink(TraceWriter *w, int i);
+
+// board index stamped on the following records of all sinks (call between batches)
+void trace_set_board(TraceWriter *w, int board);
+
+/* Writes the partly filled buffers, stops the writer and closes the file.
+ * Producers must be done. Returns false if any write failed.
+ */
+bool trace_close(TraceWriter *w);
+
+#endif // TRACE_H
@@ -1,11 +1,12 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#include <stdlib.h>
+#include "rng.h"
 
-// Function to generate a random integer between min and max (inclusive)
-static inline int roll_die(int sides) {
-    return (rand() % sides) + 1; // rand() % sides gives 0 to sides-1, so we add 1
+// Function to generate a random integer between 1 and sides (inclusive)
+// rng: random stream of the calling thread, sampling is free of modulo bias
+static inline int roll_die(Rng *rng, int sides) {
+    return (int)rng_bounded(rng, (uint32_t)sides) + 1;
 }
 
 #endif // UTILS_H
@@ -1,22 +1,77 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <limits.h>
 #include "board.h"
+#include "instrument.h"
 
 
+// rounds n up to a multiple of 64 bytes, the table starts on a cache line
+static size_t block_align(size_t n) {
+    return (n + 63) & ~(size_t)63;
+}
+
+// slots per state of the compact table, 0 if the die has no specialized kernel
+static int compact_stride(int die_sides) {
+    switch (die_sides) {
+        case 4: return 4;
+        case 6: return 8;
+        case 8: return 8;
+        default: return 0;
+    }
+}
+
 Board *create_board(int rows, int cols, int die_sides, bool exact_finish) {
-    Board *board = malloc(sizeof(Board));
-    if (!board) {
+    return create_board_reserved(rows, cols, die_sides, exact_finish, BOARD_DEFAULT_CONNECTIONS);
+}
+
+Board *create_board_reserved(int rows, int cols, int die_sides, bool exact_finish, int conn_capacity) {
+    if (rows < 1 || cols < 1 || die_sides < 1 || conn_capacity < 0 ||
+        (long long)rows * cols > BOARD_MAX_CELLS) {
+        return NULL;
+    }
+    size_t cells = (size_t)rows * (size_t)cols;
+    size_t slots = (cells + 1) * (size_t)die_sides;
+    if (slots > (SIZE_MAX / 2 - 256) / (2 * sizeof(int))) {
+        return NULL;
+    }
+
+    int stride = compact_stride(die_sides);
+    int width = stride == 0 || cells > 65535 ? 0 : cells > 255 ? 2 : 1;
+
+    // block layout: Board | cell_conn | connections | next_cell | next_conn | compact
+    size_t conn_offset = block_align(sizeof(Board) + sizeof(int) * cells);
+    size_t table_offset = block_align(conn_offset + sizeof(Connection) * (size_t)conn_capacity);
+    size_t compact_offset = block_align(table_offset + 2 * sizeof(int) * slots);
+    size_t compact_size = (cells + 1) * (size_t)stride * 2 * (size_t)width;
+    INSTR_ADD(allocs, 1);
+    char *block = aligned_alloc(64, block_align(compact_offset + compact_size));
+    if (!block) {
         return NULL; // Memory allocation failed
     }
-    
+
+    Board *board = (Board *)block;
     board->rows = rows;
     board->cols = cols;
     board->total_cells = rows * cols;
     board->num_connections = 0;
-    board->connections = NULL; // No connections initially
+    board->conn_capacity = conn_capacity;
+    board->connections = (Connection *)(block + conn_offset);
+    board->conn_external = false;
     board->die_sides = die_sides;
     board->exact_finish = exact_finish;
+    board->next_cell = NULL; // built by board_build_graph
+    board->next_conn = NULL;
+    board->table = (int *)(block + table_offset);
+    board->compact = width ? block + compact_offset : NULL;
+    board->compact_width = width;
+    board->compact_stride = width ? stride : 0;
+
+    // per-cell index so checks and lookups never scan all connections
+    board->cell_conn = (int *)(block + sizeof(Board));
+    for (int i = 0; i < board->total_cells; ++i) {
+        board->cell_conn[i] = -1;
+    }
 
     return board;
 }
@@ -24,11 +79,9 @@ Board *create_board(int rows, int cols, int die_sides, bool exact_finish) {
 void destroy_board(Board *board) {
     if (!board) return;
 
-    for (int i = 0; i < board->total_cells; ++i) {
-        free(board->adj[i]);
+    if (board->conn_external) {
+        free(board->connections);
     }
-    free(board->adj);
-    free(board->connections);
     free(board);
 }
 
@@ -64,15 +117,31 @@ void board_print(const Board *b) {
     }
 }
 
-// check if there is a connection given by 
-static bool connection_exists(const Board *b, int start, int end) {
-    //if (!b || !b->connections) return false;
-    for (int i = 0; i < b->num_connections; ++i) {
-        if (b->connections[i].start == start && b->connections[i].end == end) {
-            return true;
+bool board_reserve_connections(Board *b, int capacity) {
+    if (!b || capacity < 0) return false;
+    if (capacity <= b->conn_capacity) return true;
+    // the block is full: the connections continue in their own array
+    INSTR_ADD(allocs, 1);
+    Connection *new_array = realloc(b->conn_external ? b->connections : NULL, sizeof(Connection) * (size_t)capacity);
+    if (!new_array) {
+        perror("realloc");
+        return false;
+    }
+    if (!b->conn_external) {
+        for (int i = 0; i < b->num_connections; ++i) {
+            new_array[i] = b->connections[i];
         }
+        b->conn_external = true;
     }
-    return false;
+    b->connections = new_array;
+    b->conn_capacity = capacity;
+    return true;
+}
+
+// check if there is a connection given by start and end (O(1) via cell_conn)
+static bool connection_exists(const Board *b, int start, int end) {
+    int i = b->cell_conn[start];
+    return i >= 0 && b->connections[i].start == start && b->connections[i].end == end;
 }
 
 bool board_add_connection(Board *b, int start, int end) {
@@ -109,28 +178,20 @@ bool board_add_connection(Board *b, int start, int end) {
     }
 
     // 3. Ensure no overlap with other snakes/ladders at the same square
-    for (int i = 0; i < b->num_connections; ++i) {
-        Connection *c = &b->connections[i];
-        if (c->start == start || c->end == start) {
-            fprintf(stderr, "board_add_connection: Field %d is already a start or end of a connection\n", start);
-            return false;
-        }
-        if (c->start == end || c->end == end) {
-            fprintf(stderr, "board_add_connection: Field %d is already start or end of a connection\n", end);
-            return false;
-        }
+    if (b->cell_conn[start] >= 0) {
+        fprintf(stderr, "board_add_connection: Field %d is already a start or end of a connection\n", start);
+        return false;
+    }
+    if (b->cell_conn[end] >= 0) {
+        fprintf(stderr, "board_add_connection: Field %d is already start or end of a connection\n", end);
+        return false;
     }
 
-    // 4. Grow the array by one entry
-    Connection *new_array = realloc(
-        b->connections,
-        sizeof(Connection) * (b->num_connections + 1)
-    );
-    if (!new_array) {
-        perror("realloc");
+    // 4. Grow the array geometrically so n inserts cost O(n) in total
+    if (b->num_connections == b->conn_capacity &&
+        !board_reserve_connections(b, b->conn_capacity ? b->conn_capacity * 2 : 8)) {
         return false;
     }
-    b->connections = new_array;
 
     // 5. Add the new connection
     Connection c;
@@ -138,6 +199,8 @@ bool board_add_connection(Board *b, int start, int end) {
     c.end        = end;
     c.is_ladder  = (end > start);
     b->connections[b->num_connections] = c;
+    b->cell_conn[start] = b->num_connections;
+    b->cell_conn[end] = b->num_connections;
     b->num_connections++;
 
     return true;
@@ -147,22 +210,98 @@ void board_build_graph(Board *b) {
     if (!b) return;
     int N = b->total_cells;
     int S = b->die_sides;
-    //Array of N pointers to int arrays
-    b->adj = malloc(sizeof(int*) * N);
-    if (!b->adj) {
+    size_t slots = (size_t)(N + 1) * S;
+
+    // one contiguous row per position, the start row (-1) first,
+    // in the storage create_board set aside
+    b->next_cell = b->table;
+    b->next_conn = b->table + slots;
+
+    for (int u = -1; u < N; ++u) {
+        // for each throw one entry, the jump of a snake/ladder already resolved
+        for (int v = 1; v <= S; ++v) {
+            size_t idx = board_move_index(b, u, v);
+            int target = board_move(b, u, v);
+            int conn = target >= 0 ? b->cell_conn[target] : -1;
+            if (conn >= 0 && b->connections[conn].start != target) {
+                conn = -1; // target is only the end of a connection
+            }
+            b->next_conn[idx] = conn;
+            b->next_cell[idx] = conn >= 0 ? b->connections[conn].end : target;
+        }
+    }
+
+    // compact copy, the padding slots of a row are never read
+    for (int s = 0; b->compact && s <= N; ++s) {
+        for (int r = 0; r < S; ++r) {
+            size_t idx = (size_t)s * S + r;
+            size_t slot = (size_t)s * b->compact_stride + r;
+            if (b->compact_width == 1) {
+                BoardSlot8 *t = b->compact;
+                t[slot] = (BoardSlot8){(uint8_t)(b->next_cell[idx] + 1), (uint8_t)(b->next_conn[idx] + 1)};
+            } else {
+                BoardSlot16 *t = b->compact;
+                t[slot] = (BoardSlot16){(uint16_t)(b->next_cell[idx] + 1), (uint16_t)(b->next_conn[idx] + 1)};
+            }
+        }
+    }
+}
+
+int board_shortest_path(const Board *b, int **path) {
+    if (path) *path = NULL;
+    if (!b || !b->next_cell) return -1;
+
+    // states: 0 = before the board, c + 1 = cell c
+    int num_states = b->total_cells + 1;
+    int S = b->die_sides;
+    int goal = b->total_cells;
+    int *dist = malloc(sizeof(int) * (size_t)num_states);
+    int *parent = malloc(sizeof(int) * (size_t)num_states);
+    int *via_roll = malloc(sizeof(int) * (size_t)num_states);
+    int *queue = malloc(sizeof(int) * (size_t)num_states);
+    if (!dist || !parent || !via_roll || !queue) {
         perror("malloc");
-        exit(EXIT_FAILURE);
+        free(dist);
+        free(parent);
+        free(via_roll);
+        free(queue);
+        return -1;
+    }
+    for (int s = 0; s < num_states; ++s) {
+        dist[s] = -1;
     }
 
-    for (int u = 0; u < N; ++u) {
-        // for each throw one edge 
-        b->adj[u] = malloc(sizeof(int) * S);
-        if (!b->adj[u]) {
-            perror("malloc");
-            exit(EXIT_FAILURE);
+    int head = 0, tail = 0;
+    dist[0] = 0;
+    queue[tail++] = 0;
+    while (head < tail && dist[goal] < 0) {
+        int s = queue[head++];
+        const int *row = &b->next_cell[(size_t)s * S];
+        for (int r = 0; r < S; ++r) {
+            int n = row[r] + 1;
+            if (dist[n] >= 0) continue;
+            dist[n] = dist[s] + 1;
+            parent[n] = s;
+            via_roll[n] = r + 1;
+            queue[tail++] = n;
         }
-        for (int v = 1; v <= S; ++v) {
-            b->adj[u][v-1] = board_move(b, u, v); 
+    }
+
+    int rolls = dist[goal];
+    if (rolls > 0 && path) {
+        int *p = malloc(sizeof(int) * (size_t)rolls);
+        if (p) {
+            // walk back from the goal, filling the sequence from the end
+            for (int s = goal, i = rolls - 1; s != 0; s = parent[s], --i) {
+                p[i] = via_roll[s];
+            }
         }
+        *path = p;
     }
-}
\ No newline at end of file
+
+    free(dist);
+    free(parent);
+    free(via_roll);
+    free(queue);
+    return rolls;
+}
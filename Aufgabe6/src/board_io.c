@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "board_io.h"
+
+// size limits shared by the loaders: the same rules as on the command line
+static bool board_dims_valid(long rows, long cols, long die_sides) {
+    return rows >= 1 && cols >= 1 && die_sides >= 1 && die_sides <= INT_MAX &&
+           (long long)rows * cols <= BOARD_MAX_CELLS;
+}
+
+bool board_pack_open(const char *path, BoardPack *pack) {
+    if (!path || !pack) return false;
+    memset(pack, 0, sizeof(*pack));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BoardFileHeader)) {
+        fprintf(stderr, "%s: not a binary board file\n", path);
+        close(fd);
+        return false;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "%s: mmap: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    const BoardFileHeader *h = map;
+    size_t size = (size_t)st.st_size;
+    if (memcmp(h->magic, BOARD_FILE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != BOARD_FILE_VERSION ||
+        (size - sizeof(*h)) / sizeof(BoardRecord) < h->count) {
+        fprintf(stderr, "%s: bad header\n", path);
+        munmap(map, size);
+        return false;
+    }
+
+    const BoardRecord *records = (const BoardRecord *)(h + 1);
+    for (uint32_t i = 0; i < h->count; ++i) {
+        const BoardRecord *r = &records[i];
+        uint64_t bytes = (uint64_t)(uint32_t)r->num_connections * 2 * sizeof(int32_t);
+        if (r->num_connections < 0 || r->conn_offset % sizeof(int32_t) != 0 ||
+            r->conn_offset > size || bytes > size - r->conn_offset) {
+            fprintf(stderr, "%s: board %u: connections out of bounds\n", path, i);
+            munmap(map, size);
+            return false;
+        }
+    }
+
+    pack->map = map;
+    pack->size = size;
+    pack->count = h->count;
+    pack->records = records;
+    // boards are read front to back
+    madvise(map, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+Board *board_pack_get(const BoardPack *pack, uint32_t index) {
+    if (!pack || !pack->map || index >= pack->count) return NULL;
+    const BoardRecord *r = &pack->records[index];
+    if (!board_dims_valid(r->rows, r->cols, r->die_sides)) {
+        fprintf(stderr, "board_pack_get: board %u has invalid dimensions\n", index);
+        return NULL;
+    }
+
+    Board *b = create_board_reserved(r->rows, r->cols, r->die_sides, r->exact_finish != 0, r->num_connections);
+    if (!b) return NULL;
+    const int32_t *pairs = (const int32_t *)((const char *)pack->map + r->conn_offset);
+    for (int32_t i = 0; i < r->num_connections; ++i) {
+        if (!board_add_connection(b, pairs[2 * i], pairs[2 * i + 1])) {
+            destroy_board(b);
+            return NULL;
+        }
+    }
+    return b;
+}
+
+void board_pack_close(BoardPack *pack) {
+    if (!pack || !pack->map) return;
+    munmap(pack->map, pack->size);
+    memset(pack, 0, sizeof(*pack));
+}
+
+// appends b to set, growing the array geometrically
+static bool board_set_push(BoardSet *set, int *capacity, Board *b) {
+    if (set->count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        Board **grown = realloc(set->boards, sizeof(Board *) * (size_t)new_capacity);
+        if (!grown) {
+            perror("realloc");
+            return false;
+        }
+        set->boards = grown;
+        *capacity = new_capacity;
+    }
+    set->boards[set->count++] = b;
+    return true;
+}
+
+static bool board_file_load_binary(const char *path, BoardSet *set) {
+    BoardPack pack;
+    if (!board_pack_open(path, &pack)) return false;
+
+    bool ok = true;
+    int capacity = 0;
+    for (uint32_t i = 0; i < pack.count && ok; ++i) {
+        Board *b = board_pack_get(&pack, i);
+        ok = b && board_set_push(set, &capacity, b);
+        if (!ok) destroy_board(b);
+    }
+    board_pack_close(&pack);
+    return ok;
+}
+
+static bool board_file_load_text(const char *path, FILE *f, BoardSet *set) {
+    char *line = NULL;
+    size_t line_cap = 0;
+    int line_no = 0;
+    int capacity = 0;
+    Board *current = NULL;
+    bool ok = true;
+
+    while (ok && getline(&line, &line_cap, f) != -1) {
+        ++line_no;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char word[16];
+        long a, b, c, d;
+        if (sscanf(line, " %15s", word) != 1) continue; // blank or comment
+
+        if (strcmp(word, "board") == 0) {
+            int fields = sscanf(line, " board %ld %ld %ld %ld", &a, &b, &c, &d);
+            if (fields != 4 || !board_dims_valid(a, b, c) || (d != 0 && d != 1)) {
+                fprintf(stderr, "%s:%d: expected 'board <rows> <cols> <die_sides> <0|1>'\n", path, line_no);
+                ok = false;
+                break;
+            }
+            current = create_board((int)a, (int)b, (int)c, d == 1);
+            ok = current && board_set_push(set, &capacity, current);
+            if (!ok) destroy_board(current);
+        } else if (current && sscanf(line, " %ld %ld", &a, &b) == 2) {
+            if (a < INT_MIN || a > INT_MAX || b < INT_MIN || b > INT_MAX ||
+                !board_add_connection(current, (int)a, (int)b)) {
+                fprintf(stderr, "%s:%d: invalid connection\n", path, line_no);
+                ok = false;
+            }
+        } else {
+            fprintf(stderr, "%s:%d: expected a 'board' line or '<start> <end>'\n", path, line_no);
+            ok = false;
+        }
+    }
+    free(line);
+    return ok;
+}
+
+bool board_file_load(const char *path, BoardSet *set) {
+    if (!path || !set) return false;
+    set->boards = NULL;
+    set->count = 0;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    char magic[sizeof(((BoardFileHeader *)0)->magic)];
+    bool binary = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+                  memcmp(magic, BOARD_FILE_MAGIC, sizeof(magic)) == 0;
+
+    bool ok;
+    if (binary) {
+        fclose(f);
+        ok = board_file_load_binary(path, set);
+    } else {
+        rewind(f);
+        ok = board_file_load_text(path, f, set);
+        fclose(f);
+    }
+    if (ok && set->count == 0) {
+        fprintf(stderr, "%s: no boards\n", path);
+        ok = false;
+    }
+    if (!ok) board_set_free(set);
+    return ok;
+}
+
+void board_set_free(BoardSet *set) {
+    if (!set) return;
+    for (int i = 0; i < set->count; ++i) {
+        destroy_board(set->boards[i]);
+    }
+    free(set->boards);
+    set->boards = NULL;
+    set->count = 0;
+}
+
+bool board_file_save_binary(const char *path, Board *const *boards, int count) {
+    if (!path || (!boards && count > 0) || count < 0) return false;
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    BoardFileHeader h;
+    memcpy(h.magic, BOARD_FILE_MAGIC, sizeof(h.magic));
+    h.version = BOARD_FILE_VERSION;
+    h.count = (uint32_t)count;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+
+    // records first, the connection pairs follow in board order
+    uint64_t offset = sizeof(h) + (uint64_t)count * sizeof(BoardRecord);
+    for (int i = 0; ok && i < count; ++i) {
+        const Board *b = boards[i];
+        BoardRecord r = {
+            .rows = b->rows,
+            .cols = b->cols,
+            .die_sides = b->die_sides,
+            .exact_finish = b->exact_finish ? 1 : 0,
+            .num_connections = b->num_connections,
+            .reserved = 0,
+            .conn_offset = offset,
+        };
+        ok = fwrite(&r, sizeof(r), 1, f) == 1;
+        offset += (uint64_t)b->num_connections * 2 * sizeof(int32_t);
+    }
+    for (int i = 0; ok && i < count; ++i) {
+        const Board *b = boards[i];
+        for (int k = 0; ok && k < b->num_connections; ++k) {
+            int32_t pair[2] = {b->connections[k].start, b->connections[k].end};
+            ok = fwrite(pair, sizeof(pair), 1, f) == 1;
+        }
+    }
+
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "%s: write failed\n", path);
+    return ok;
+}
+
+bool board_file_save_text(const char *path, Board *const *boards, int count) {
+    if (!path || (!boards && count > 0) || count < 0) return false;
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        const Board *b = boards[i];
+        fprintf(f, "board %d %d %d %d\n", b->rows, b->cols, b->die_sides, b->exact_finish ? 1 : 0);
+        for (int k = 0; k < b->num_connections; ++k) {
+            fprintf(f, "%d %d\n", b->connections[k].start, b->connections[k].end);
+        }
+    }
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "%s: write failed\n", path);
+    return ok;
+}
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "checkpoint.h"
+#include "result_io.h"
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    int32_t reserved;
+    int32_t num_connections;
+    int32_t max_steps;
+    int32_t played;
+    int32_t round;
+    CheckpointKey key;
+} CheckpointHeader;
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+uint64_t checkpoint_board_hash(const Board *b) {
+    int32_t dims[4] = {b->rows, b->cols, b->die_sides, b->exact_finish};
+    uint64_t h = fnv1a(0xcbf29ce484222325ULL, dims, sizeof(dims));
+    for (int i = 0; i < b->num_connections; ++i) {
+        int32_t pair[2] = {b->connections[i].start, b->connections[i].end};
+        h = fnv1a(h, pair, sizeof(pair));
+    }
+    return h;
+}
+
+static size_t checkpoint_size(const CheckpointState *s, int num_connections) {
+    return sizeof(CheckpointHeader) + result_io_size(&s->result, num_connections);
+}
+
+static void checkpoint_serialize(const CheckpointState *s, int num_connections, char *buf) {
+    CheckpointHeader h = {
+        .version = CHECKPOINT_VERSION,
+        .num_connections = num_connections,
+        .max_steps = s->result.max_steps,
+        .played = s->played,
+        .round = s->round,
+        .key = s->key,
+    };
+    memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+    memcpy(buf, &h, sizeof(h));
+    result_io_put(buf + sizeof(h), &s->result, num_connections);
+}
+
+// blocks of the shard the key plays, the bound of CheckpointState.played
+static int checkpoint_shard_blocks(const CheckpointKey *key) {
+    if (key->num_games < 1 || key->block_games < 1 || key->shard_count < 1) return 0;
+    long long num_blocks = (key->num_games - 1) / key->block_games + 1;
+    return (int)(num_blocks * (key->shard_index + 1) / key->shard_count -
+                 num_blocks * key->shard_index / key->shard_count);
+}
+
+bool checkpoint_load(const char *path, const CheckpointKey *key, int num_connections, CheckpointState *out) {
+    if (!path || !key || !out) return false;
+    memset(out, 0, sizeof(*out));
+
+    size_t size = 0;
+    char *buf = result_io_read_file(path, &size);
+    if (!buf) return false;
+
+    size_t pos = 0;
+    CheckpointHeader h;
+    bool ok = result_io_take(buf, size, &pos, &h, sizeof(h)) &&
+              memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic)) == 0 && h.version == CHECKPOINT_VERSION;
+    if (!ok) {
+        fprintf(stderr, "%s: not a checkpoint file\n", path);
+        free(buf);
+        return false;
+    }
+    if (memcmp(&h.key, key, sizeof(*key)) != 0 || h.num_connections != num_connections ||
+        h.max_steps != key->max_steps ||
+        h.played < 0 || h.played > checkpoint_shard_blocks(key) || h.round < 1) {
+        fprintf(stderr, "%s: checkpoint of a different run (board or options changed)\n", path);
+        free(buf);
+        return false;
+    }
+
+    out->key = h.key;
+    out->played = h.played;
+    out->round = h.round;
+    ok = result_io_get(buf, size, &pos, num_connections, h.max_steps, &out->result);
+    if (ok && pos != size) {
+        batch_result_free(&out->result);
+        ok = false;
+    }
+    free(buf);
+    if (!ok) {
+        fprintf(stderr, "%s: damaged checkpoint file\n", path);
+        return false;
+    }
+    return true;
+}
+
+void checkpoint_state_free(CheckpointState *state) {
+    if (!state) return;
+    batch_result_free(&state->result);
+}
+
+struct CheckpointWriter {
+    char *path;
+    pthread_t thread;
+    bool running;      // a write is in flight on thread
+    bool failed;
+    char *buf;         // serialized checkpoint of the write in flight
+    size_t size;
+};
+
+static void *checkpoint_writer_run(void *arg) {
+    CheckpointWriter *w = arg;
+    if (!result_io_write_file(w->path, w->buf, w->size)) w->failed = true;
+    return NULL;
+}
+
+CheckpointWriter *checkpoint_writer_create(const char *path) {
+    if (!path) return NULL;
+    CheckpointWriter *w = calloc(1, sizeof(CheckpointWriter));
+    size_t len = strlen(path);
+    if (w) w->path = malloc(len + 1);
+    if (!w || !w->path) {
+        perror("malloc");
+        free(w);
+        return NULL;
+    }
+    memcpy(w->path, path, len + 1);
+    return w;
+}
+
+// waits for the write in flight, if any
+static void checkpoint_writer_wait(CheckpointWriter *w) {
+    if (w->running) {
+        pthread_join(w->thread, NULL);
+        w->running = false;
+    }
+    free(w->buf);
+    w->buf = NULL;
+}
+
+bool checkpoint_writer_submit(CheckpointWriter *w, const CheckpointState *state, int num_connections) {
+    if (!w || !state) return false;
+    checkpoint_writer_wait(w);
+
+    w->size = checkpoint_size(state, num_connections);
+    w->buf = malloc(w->size);
+    if (!w->buf) {
+        perror("malloc");
+        return false;
+    }
+    checkpoint_serialize(state, num_connections, w->buf);
+
+    // written on this thread if no writer thread can be started
+    w->running = pthread_create(&w->thread, NULL, checkpoint_writer_run, w) == 0;
+    if (!w->running && !result_io_write_file(w->path, w->buf, w->size)) w->failed = true;
+    return true;
+}
+
+bool checkpoint_writer_finish(CheckpointWriter *w) {
+    if (!w) return false;
+    checkpoint_writer_wait(w);
+    bool ok = !w->failed;
+    free(w->path);
+    free(w);
+    return ok;
+}
@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "designer.h"
+#include "board.h"
+#include "markov.h"
+#include "rng.h"
+
+#define DESIGN_MAX_SWEEPS 10000
+#define DESIGN_TEMP_START 1e-2
+#define DESIGN_TEMP_END 1e-6
+
+/* state of one annealing chain */
+typedef struct {
+    const DesignSpec *spec;
+    Rng rng;
+    bool ok;           // found a board that can always be won
+    int (*pairs)[2];   // current connections
+    int *jump;         // per cell: where landing there ends up
+    int *owner;        // per cell: connection starting or ending there, -1 if none
+    double *t, *m2;    // solution of the current board (warm start)
+    double *ct, *cm2;  // candidate solution
+    int (*best)[2];
+    double best_mean, best_variance, best_cost;
+    long evaluations;
+} DesignChain;
+
+static double design_cost(const DesignSpec *spec, double mean, double variance) {
+    double e = (mean - spec->target_mean) / spec->target_mean;
+    double cost = e * e;
+    if (spec->target_stddev > 0.0) {
+        double sd = variance > 0.0 ? sqrt(variance) : 0.0;
+        double f = (sd - spec->target_stddev) / spec->target_stddev;
+        cost += f * f;
+    }
+    return cost;
+}
+
+// candidate = current board; false if it can not always be won
+static bool design_evaluate(DesignChain *ch, bool warm, double *mean, double *variance) {
+    const DesignSpec *spec = ch->spec;
+    int cells = spec->rows * spec->cols;
+    size_t bytes = sizeof(double) * ((size_t)cells + 1);
+    if (warm) {
+        memcpy(ch->ct, ch->t, bytes);
+        memcpy(ch->cm2, ch->m2, bytes);
+    } else {
+        memset(ch->ct, 0, bytes);
+        memset(ch->cm2, 0, bytes);
+    }
+    double limit = 100.0 * (spec->target_mean + cells);
+    ch->evaluations++;
+    return markov_moments(cells, spec->die_sides, spec->exact_finish, ch->jump,
+                          DESIGN_MAX_SWEEPS, limit, ch->ct, ch->cm2, mean, variance);
+}
+
+static void design_link(DesignChain *ch, int i, int start, int end) {
+    ch->pairs[i][0] = start;
+    ch->pairs[i][1] = end;
+    ch->owner[start] = i;
+    ch->owner[end] = i;
+    ch->jump[start] = end;
+}
+
+static void design_unlink(DesignChain *ch, int i) {
+    int start = ch->pairs[i][0];
+    int end = ch->pairs[i][1];
+    ch->owner[start] = -1;
+    ch->owner[end] = -1;
+    ch->jump[start] = start;
+}
+
+// random free cell, never the last one if it is to be a start
+static int design_free_cell(DesignChain *ch, bool for_start) {
+    int cells = ch->spec->rows * ch->spec->cols;
+    for (;;) {
+        int c = (int)rng_bounded(&ch->rng, (uint32_t)(for_start ? cells - 1 : cells));
+        if (ch->owner[c] < 0) return c;
+    }
+}
+
+static void *design_chain_run(void *arg) {
+    DesignChain *ch = arg;
+    const DesignSpec *spec = ch->spec;
+    int cells = spec->rows * spec->cols;
+    int k = spec->num_connections;
+
+    for (int c = 0; c < cells; ++c) {
+        ch->jump[c] = c;
+        ch->owner[c] = -1;
+    }
+    for (int i = 0; i < k; ++i) {
+        int start = design_free_cell(ch, true);
+        ch->owner[start] = i; // reserve before drawing the end
+        int end = design_free_cell(ch, false);
+        design_link(ch, i, start, end);
+    }
+
+    double mean = 0.0, variance = 0.0;
+    bool valid = design_evaluate(ch, false, &mean, &variance);
+    double cost = valid ? design_cost(spec, mean, variance) : INFINITY;
+    if (valid) {
+        double *tmp = ch->t; ch->t = ch->ct; ch->ct = tmp;
+        tmp = ch->m2; ch->m2 = ch->cm2; ch->cm2 = tmp;
+    }
+    ch->best_cost = INFINITY;
+    if (valid) {
+        memcpy(ch->best, ch->pairs, sizeof(*ch->pairs) * k);
+        ch->best_mean = mean;
+        ch->best_variance = variance;
+        ch->best_cost = cost;
+    }
+
+    double cooling = spec->iterations > 1
+                   ? pow(DESIGN_TEMP_END / DESIGN_TEMP_START, 1.0 / (spec->iterations - 1)) : 1.0;
+    double temp = DESIGN_TEMP_START;
+    for (int it = 0; it < spec->iterations && k > 0 && ch->best_cost > 0.0; ++it, temp *= cooling) {
+        // move the start or the end of one connection to a free cell
+        int i = (int)rng_bounded(&ch->rng, (uint32_t)k);
+        int old_start = ch->pairs[i][0];
+        int old_end = ch->pairs[i][1];
+        bool move_start = rng_next(&ch->rng) >> 63;
+        design_unlink(ch, i);
+        ch->owner[move_start ? old_end : old_start] = i;
+        int cell = design_free_cell(ch, move_start);
+        ch->owner[move_start ? old_end : old_start] = -1;
+        if (move_start) design_link(ch, i, cell, old_end);
+        else            design_link(ch, i, old_start, cell);
+
+        double cand_mean, cand_variance;
+        bool cand_valid = design_evaluate(ch, valid, &cand_mean, &cand_variance);
+        double cand_cost = cand_valid ? design_cost(spec, cand_mean, cand_variance) : INFINITY;
+        double u = (double)(rng_next(&ch->rng) >> 11) * 0x1.0p-53;
+        bool accept = cand_valid &&
+                      (cand_cost <= cost || u < exp((cost - cand_cost) / temp));
+        if (!accept) {
+            design_unlink(ch, i);
+            design_link(ch, i, old_start, old_end);
+            continue;
+        }
+
+        valid = true;
+        cost = cand_cost;
+        double *tmp = ch->t; ch->t = ch->ct; ch->ct = tmp;
+        tmp = ch->m2; ch->m2 = ch->cm2; ch->cm2 = tmp;
+        if (cost < ch->best_cost) {
+            memcpy(ch->best, ch->pairs, sizeof(*ch->pairs) * k);
+            ch->best_mean = cand_mean;
+            ch->best_variance = cand_variance;
+            ch->best_cost = cost;
+        }
+    }
+    ch->ok = ch->best_cost < INFINITY;
+    return NULL;
+}
+
+static void design_chain_free(DesignChain *ch) {
+    free(ch->pairs);
+    free(ch->jump);
+    free(ch->owner);
+    free(ch->t);
+    free(ch->m2);
+    free(ch->ct);
+    free(ch->cm2);
+    free(ch->best);
+}
+
+bool designer_run(const DesignSpec *spec, DesignResult *out) {
+    if (!spec || !out || spec->rows < 1 || spec->cols < 1 || spec->die_sides < 1 ||
+        spec->num_connections < 0 || spec->num_chains < 1 || spec->iterations < 0 ||
+        !(spec->target_mean > 0.0) ||
+        (long long)spec->rows * spec->cols > BOARD_MAX_CELLS) {
+        return false;
+    }
+    int cells = spec->rows * spec->cols;
+    // every connection needs two cells and the last cell can not be a start
+    if (2LL * spec->num_connections > cells - 1) {
+        fprintf(stderr, "designer_run: %d connections do not fit %d cells\n",
+                spec->num_connections, cells);
+        return false;
+    }
+
+    int n = spec->num_chains;
+    DesignChain *chains = calloc(n, sizeof(DesignChain));
+    pthread_t *threads = malloc(sizeof(pthread_t) * n);
+    bool *started = calloc(n, sizeof(bool));
+    bool ok = chains && threads && started;
+
+    Rng stream;
+    rng_seed(&stream, spec->seed);
+    size_t k = (size_t)spec->num_connections;
+    for (int c = 0; ok && c < n; ++c) {
+        DesignChain *ch = &chains[c];
+        ch->spec = spec;
+        ch->rng = stream;
+        rng_long_jump(&stream);
+        ch->pairs = malloc(sizeof(*ch->pairs) * (k + 1));
+        ch->best = malloc(sizeof(*ch->best) * (k + 1));
+        ch->jump = malloc(sizeof(int) * cells);
+        ch->owner = malloc(sizeof(int) * cells);
+        ch->t = malloc(sizeof(double) * ((size_t)cells + 1));
+        ch->m2 = malloc(sizeof(double) * ((size_t)cells + 1));
+        ch->ct = malloc(sizeof(double) * ((size_t)cells + 1));
+        ch->cm2 = malloc(sizeof(double) * ((size_t)cells + 1));
+        ok = ch->pairs && ch->best && ch->jump && ch->owner && ch->t && ch->m2 && ch->ct && ch->cm2;
+    }
+    if (!ok) perror("malloc");
+
+    // chain 0 runs on the calling thread, as does any chain whose thread fails to start
+    for (int c = 1; ok && c < n; ++c) {
+        started[c] = pthread_create(&threads[c], NULL, design_chain_run, &chains[c]) == 0;
+    }
+    if (ok) design_chain_run(&chains[0]);
+    for (int c = 1; ok && c < n; ++c) {
+        if (started[c]) pthread_join(threads[c], NULL);
+        else design_chain_run(&chains[c]);
+    }
+
+    int winner = -1;
+    long evaluations = 0;
+    for (int c = 0; ok && c < n; ++c) {
+        evaluations += chains[c].evaluations;
+        if (chains[c].ok && (winner < 0 || chains[c].best_cost < chains[winner].best_cost)) {
+            winner = c;
+        }
+    }
+    if (ok && winner >= 0) {
+        out->pairs = chains[winner].best;
+        chains[winner].best = NULL;
+        out->num_pairs = spec->num_connections;
+        out->mean = chains[winner].best_mean;
+        out->variance = chains[winner].best_variance;
+        out->cost = chains[winner].best_cost;
+        out->evaluations = evaluations;
+    }
+
+    for (int c = 0; chains && c < n; ++c) {
+        design_chain_free(&chains[c]);
+    }
+    free(chains);
+    free(threads);
+    free(started);
+    return ok && winner >= 0;
+}
+
+void design_result_free(DesignResult *res) {
+    if (!res) return;
+    free(res->pairs);
+    res->pairs = NULL;
+    res->num_pairs = 0;
+}
@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include "instrument.h"
+
+#ifdef SL_INSTRUMENT
+
+#include <pthread.h>
+
+_Thread_local InstrCounters instr_local;
+
+static InstrCounters instr_total;
+static pthread_mutex_t instr_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void instr_flush(void) {
+    pthread_mutex_lock(&instr_lock);
+    instr_total.moves += instr_local.moves;
+    instr_total.conn_hits += instr_local.conn_hits;
+    instr_total.bounces += instr_local.bounces;
+    instr_total.timeouts += instr_local.timeouts;
+    instr_total.allocs += instr_local.allocs;
+    instr_total.play_sec += instr_local.play_sec;
+    instr_total.aggregate_sec += instr_local.aggregate_sec;
+    pthread_mutex_unlock(&instr_lock);
+    instr_local = (InstrCounters){0};
+}
+
+void instr_report(FILE *out) {
+    instr_flush();
+    fprintf(out, "+--------------------------------+\n");
+    fprintf(out, "|     Instrumentation            |\n");
+    fprintf(out, "+--------------------------------+\n");
+    fprintf(out, "| Moves:          %14ld |\n", instr_total.moves);
+    fprintf(out, "| Connection hits:%14ld |\n", instr_total.conn_hits);
+    fprintf(out, "| Bounces:        %14ld |\n", instr_total.bounces);
+    fprintf(out, "| Timeouts:       %14ld |\n", instr_total.timeouts);
+    fprintf(out, "| Allocator calls:%14ld |\n", instr_total.allocs);
+    fprintf(out, "| Play time:      %12.3f s |\n", instr_total.play_sec);
+    fprintf(out, "| Aggregation:    %12.3f s |\n", instr_total.aggregate_sec);
+    fprintf(out, "+--------------------------------+\n");
+}
+
+#else
+
+void instr_report(FILE *out) {
+    fprintf(out, "Instrumentation not compiled in (rebuild with make INSTRUMENT=1)\n");
+}
+
+#endif // SL_INSTRUMENT
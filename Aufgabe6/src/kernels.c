@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include "kernels.h"
+#include "simulator.h"
+#include "instrument.h"
+
+/* One kernel per die size D and slot type. State 0 is the position before
+ * the board, the goal state is total_cells (the last cell).
+ */
+#define SIM_KERNEL(NAME, SLOT, D, STRIDE)                                              \
+    static int NAME(const Board *b, Rng *rng, int max_steps, long *conn_counts, int *conn_hits) { \
+        const SLOT *table = b->compact;                                                \
+        const unsigned goal = (unsigned)b->total_cells;                                \
+        unsigned state = 0;                                                            \
+        int hits = 0;                                                                  \
+        _Pragma("GCC unroll 4")                                                        \
+        for (int rolls = 1; rolls <= max_steps; ++rolls) {                             \
+            SLOT slot = table[state * (STRIDE) + rng_bounded(rng, (D))];               \
+            INSTR_ADD(bounces, slot.cell == state && slot.conn == 0);                  \
+            state = slot.cell;                                                         \
+            if (slot.conn) {                                                           \
+                conn_counts[slot.conn - 1]++;                                          \
+                hits++;                                                                \
+                INSTR_ADD(conn_hits, 1);                                               \
+            }                                                                          \
+            if (state == goal) {                                                       \
+                *conn_hits = hits;                                                     \
+                return rolls;                                                          \
+            }                                                                          \
+        }                                                                              \
+        *conn_hits = hits;                                                             \
+        return 0;                                                                      \
+    }
+
+SIM_KERNEL(sim_kernel_d4_u8, BoardSlot8, 4, 4)
+SIM_KERNEL(sim_kernel_d6_u8, BoardSlot8, 6, 8)
+SIM_KERNEL(sim_kernel_d8_u8, BoardSlot8, 8, 8)
+SIM_KERNEL(sim_kernel_d4_u16, BoardSlot16, 4, 4)
+SIM_KERNEL(sim_kernel_d6_u16, BoardSlot16, 6, 8)
+SIM_KERNEL(sim_kernel_d8_u16, BoardSlot16, 8, 8)
+
+SimKernel sim_kernel_pick(const Board *b, const char **name) {
+    static const struct {
+        int die_sides;
+        int width;
+        SimKernel kernel;
+        const char *name;
+    } kernels[] = {
+        {4, 1, sim_kernel_d4_u8, "d4/u8"},
+        {6, 1, sim_kernel_d6_u8, "d6/u8"},
+        {8, 1, sim_kernel_d8_u8, "d8/u8"},
+        {4, 2, sim_kernel_d4_u16, "d4/u16"},
+        {6, 2, sim_kernel_d6_u16, "d6/u16"},
+        {8, 2, sim_kernel_d8_u16, "d8/u16"},
+    };
+    if (b && b->compact && b->next_cell) {
+        for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); ++i) {
+            if (kernels[i].die_sides == b->die_sides && kernels[i].width == b->compact_width) {
+                if (name) *name = kernels[i].name;
+                return kernels[i].kernel;
+            }
+        }
+    }
+    if (name) *name = "generic";
+    return simulator_play_counted;
+}
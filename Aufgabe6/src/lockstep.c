@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include "lockstep.h"
+#include "utils.h"
+#include "instrument.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LOCKSTEP_X86 1
+#endif
+
+/* all lanes in structure-of-arrays form */
+typedef struct {
+    uint64_t s[4][LOCKSTEP_LANES]; // xoshiro256** state words, one column per lane
+    int32_t pos[LOCKSTEP_LANES];
+    int32_t rolls[LOCKSTEP_LANES];
+    int32_t hits[LOCKSTEP_LANES]; // connections taken in the current game
+} LockstepLanes;
+
+typedef struct {
+    const int *next_cell;
+    const int *next_conn;
+    int die_sides;
+    int last;
+    int max_steps;
+} LockstepTable;
+
+/* Advances every lane by one roll until at least one active lane wins or
+ * reaches max_steps, returns the mask of those lanes. Connections traversed
+ * by active lanes are counted on the way.
+ */
+typedef uint32_t (*LockstepAdvance)(LockstepLanes *L, const LockstepTable *t, uint32_t active, long *conn_counts);
+
+static inline Rng lane_rng(const LockstepLanes *L, int lane) {
+    Rng r;
+    for (int k = 0; k < 4; ++k) {
+        r.s[k] = L->s[k][lane];
+    }
+    return r;
+}
+
+static inline void lane_set_rng(LockstepLanes *L, int lane, const Rng *r) {
+    for (int k = 0; k < 4; ++k) {
+        L->s[k][lane] = r->s[k];
+    }
+}
+
+/* Finishes rng_bounded for a lane whose first draw m = (x >> 32) * n may lie
+ * in the rejection zone, so the vector kernels draw exactly what the scalar one does.
+ */
+static uint64_t lane_redraw(LockstepLanes *L, int lane, uint64_t m, uint32_t n) {
+    uint32_t low = (uint32_t)m;
+    uint32_t threshold = -n % n;
+    if (low >= threshold) return m;
+
+    Rng r = lane_rng(L, lane);
+    while (low < threshold) {
+        m = (rng_next(&r) >> 32) * (uint64_t)n;
+        low = (uint32_t)m;
+    }
+    lane_set_rng(L, lane, &r);
+    return m;
+}
+
+static uint32_t lockstep_advance_scalar(LockstepLanes *L, const LockstepTable *t, uint32_t active, long *conn_counts) {
+    for (;;) {
+        uint32_t done = 0;
+        for (int l = 0; l < LOCKSTEP_LANES; ++l) {
+            Rng r = lane_rng(L, l);
+            int roll = roll_die(&r, t->die_sides);
+            lane_set_rng(L, l, &r);
+
+            size_t idx = (size_t)(L->pos[l] + 1) * (size_t)t->die_sides + (size_t)(roll - 1);
+            int conn = t->next_conn[idx];
+            L->pos[l] = t->next_cell[idx];
+            L->rolls[l]++;
+
+            if (!((active >> l) & 1u)) continue;
+            if (conn >= 0) {
+                conn_counts[conn]++;
+                L->hits[l]++;
+                INSTR_ADD(conn_hits, 1);
+            }
+            if (L->pos[l] == t->last || L->rolls[l] == t->max_steps) {
+                done |= 1u << l;
+            }
+        }
+        if (done) return done;
+    }
+}
+
+#ifdef LOCKSTEP_X86
+
+#define LS_ROTL256(x, k) _mm256_or_si256(_mm256_slli_epi64((x), (k)), _mm256_srli_epi64((x), 64 - (k)))
+
+/* table lookup and bookkeeping shared by both vector kernels;
+ * roll is 0-based, returns the mask of finished active lanes
+ */
+#define LS_LOOKUP_AND_CHECK()                                                              \
+    do {                                                                                   \
+        __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(pos, one), sides), roll); \
+        __m256i conn = _mm256_i32gather_epi32(t->next_conn, idx, 4);                       \
+        pos = _mm256_i32gather_epi32(t->next_cell, idx, 4);                                \
+        rolls = _mm256_add_epi32(rolls, one);                                              \
+                                                                                           \
+        uint32_t hits = (uint32_t)_mm256_movemask_ps(                                      \
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(conn, none))) & active;                 \
+        if (hits) {                                                                        \
+            int32_t c[LOCKSTEP_LANES];                                                     \
+            _mm256_storeu_si256((__m256i *)c, conn);                                       \
+            while (hits) {                                                                 \
+                conn_counts[c[__builtin_ctz(hits)]]++;                                     \
+                L->hits[__builtin_ctz(hits)]++;                                            \
+                INSTR_ADD(conn_hits, 1);                                                   \
+                hits &= hits - 1;                                                          \
+            }                                                                              \
+        }                                                                                  \
+        uint32_t done = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(                  \
+            _mm256_or_si256(_mm256_cmpeq_epi32(pos, last), _mm256_cmpeq_epi32(rolls, max_steps)))) & active; \
+        if (done) {                                                                        \
+            _mm256_storeu_si256((__m256i *)L->pos, pos);                                   \
+            _mm256_storeu_si256((__m256i *)L->rolls, rolls);                               \
+            return done;                                                                   \
+        }                                                                                  \
+    } while (0)
+
+__attribute__((target("avx2")))
+static uint32_t lockstep_advance_avx2(LockstepLanes *L, const LockstepTable *t, uint32_t active, long *conn_counts) {
+    const uint32_t n = (uint32_t)t->die_sides;
+    const __m256i n64 = _mm256_set1_epi64x(n);
+    const __m256i low_mask = _mm256_set1_epi64x(0xffffffffLL);
+    const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i none = _mm256_set1_epi32(-1);
+    const __m256i sides = _mm256_set1_epi32(t->die_sides);
+    const __m256i last = _mm256_set1_epi32(t->last);
+    const __m256i max_steps = _mm256_set1_epi32(t->max_steps);
+    __m256i pos = _mm256_loadu_si256((const __m256i *)L->pos);
+    __m256i rolls = _mm256_loadu_si256((const __m256i *)L->rolls);
+
+    for (;;) {
+        // two halves of four 64-bit generators each
+        __m256i m[2];
+        uint32_t reject = 0;
+        for (int h = 0; h < 2; ++h) {
+            __m256i *p0 = (__m256i *)&L->s[0][4 * h];
+            __m256i *p1 = (__m256i *)&L->s[1][4 * h];
+            __m256i *p2 = (__m256i *)&L->s[2][4 * h];
+            __m256i *p3 = (__m256i *)&L->s[3][4 * h];
+            __m256i s0 = _mm256_loadu_si256(p0);
+            __m256i s1 = _mm256_loadu_si256(p1);
+            __m256i s2 = _mm256_loadu_si256(p2);
+            __m256i s3 = _mm256_loadu_si256(p3);
+
+            // rotl(s1 * 5, 7) * 9 with shifts and adds, AVX2 has no 64-bit multiply
+            __m256i x = _mm256_add_epi64(s1, _mm256_slli_epi64(s1, 2));
+            x = LS_ROTL256(x, 7);
+            __m256i result = _mm256_add_epi64(x, _mm256_slli_epi64(x, 3));
+
+            __m256i tmp = _mm256_slli_epi64(s1, 17);
+            s2 = _mm256_xor_si256(s2, s0);
+            s3 = _mm256_xor_si256(s3, s1);
+            s1 = _mm256_xor_si256(s1, s2);
+            s0 = _mm256_xor_si256(s0, s3);
+            s2 = _mm256_xor_si256(s2, tmp);
+            s3 = LS_ROTL256(s3, 45);
+            _mm256_storeu_si256(p0, s0);
+            _mm256_storeu_si256(p1, s1);
+            _mm256_storeu_si256(p2, s2);
+            _mm256_storeu_si256(p3, s3);
+
+            // Lemire: (x >> 32) * n, the high half is the roll
+            m[h] = _mm256_mul_epu32(_mm256_srli_epi64(result, 32), n64);
+            __m256i low = _mm256_and_si256(m[h], low_mask);
+            reject |= (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(n64, low))) << (4 * h);
+        }
+
+        __m256i roll;
+        if (reject) {
+            // rare: finish the rejection sampling lane by lane
+            uint64_t ms[LOCKSTEP_LANES];
+            int32_t r[LOCKSTEP_LANES];
+            _mm256_storeu_si256((__m256i *)ms, m[0]);
+            _mm256_storeu_si256((__m256i *)(ms + 4), m[1]);
+            for (int l = 0; l < LOCKSTEP_LANES; ++l) {
+                if ((reject >> l) & 1u) ms[l] = lane_redraw(L, l, ms[l], n);
+                r[l] = (int32_t)(ms[l] >> 32);
+            }
+            roll = _mm256_loadu_si256((const __m256i *)r);
+        } else {
+            __m256i lo = _mm256_permutevar8x32_epi32(_mm256_srli_epi64(m[0], 32), even);
+            __m256i hi = _mm256_permutevar8x32_epi32(_mm256_srli_epi64(m[1], 32), even);
+            roll = _mm256_permute2x128_si256(lo, hi, 0x20);
+        }
+
+        LS_LOOKUP_AND_CHECK();
+    }
+}
+
+__attribute__((target("avx512f,avx2")))
+static uint32_t lockstep_advance_avx512(LockstepLanes *L, const LockstepTable *t, uint32_t active, long *conn_counts) {
+    const uint32_t n = (uint32_t)t->die_sides;
+    const __m512i n64 = _mm512_set1_epi64(n);
+    const __m512i low_mask = _mm512_set1_epi64(0xffffffffLL);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i none = _mm256_set1_epi32(-1);
+    const __m256i sides = _mm256_set1_epi32(t->die_sides);
+    const __m256i last = _mm256_set1_epi32(t->last);
+    const __m256i max_steps = _mm256_set1_epi32(t->max_steps);
+    __m256i pos = _mm256_loadu_si256((const __m256i *)L->pos);
+    __m256i rolls = _mm256_loadu_si256((const __m256i *)L->rolls);
+
+    for (;;) {
+        // all eight 64-bit generators in one register
+        __m512i s0 = _mm512_loadu_si512(L->s[0]);
+        __m512i s1 = _mm512_loadu_si512(L->s[1]);
+        __m512i s2 = _mm512_loadu_si512(L->s[2]);
+        __m512i s3 = _mm512_loadu_si512(L->s[3]);
+
+        __m512i x = _mm512_rol_epi64(_mm512_add_epi64(s1, _mm512_slli_epi64(s1, 2)), 7);
+        __m512i result = _mm512_add_epi64(x, _mm512_slli_epi64(x, 3));
+
+        __m512i tmp = _mm512_slli_epi64(s1, 17);
+        s2 = _mm512_xor_si512(s2, s0);
+        s3 = _mm512_xor_si512(s3, s1);
+        s1 = _mm512_xor_si512(s1, s2);
+        s0 = _mm512_xor_si512(s0, s3);
+        s2 = _mm512_xor_si512(s2, tmp);
+        s3 = _mm512_rol_epi64(s3, 45);
+        _mm512_storeu_si512(L->s[0], s0);
+        _mm512_storeu_si512(L->s[1], s1);
+        _mm512_storeu_si512(L->s[2], s2);
+        _mm512_storeu_si512(L->s[3], s3);
+
+        __m512i m = _mm512_mul_epu32(_mm512_srli_epi64(result, 32), n64);
+        __mmask8 reject = _mm512_cmplt_epu64_mask(_mm512_and_si512(m, low_mask), n64);
+        if (reject) {
+            uint64_t ms[LOCKSTEP_LANES];
+            _mm512_storeu_si512(ms, m);
+            for (int l = 0; l < LOCKSTEP_LANES; ++l) {
+                if ((reject >> l) & 1u) ms[l] = lane_redraw(L, l, ms[l], n);
+            }
+            m = _mm512_loadu_si512(ms);
+        }
+        __m256i roll = _mm512_cvtepi64_epi32(_mm512_srli_epi64(m, 32));
+
+        LS_LOOKUP_AND_CHECK();
+    }
+}
+
+#endif // LOCKSTEP_X86
+
+static LockstepAdvance lockstep_pick_kernel(const char **name) {
+#ifdef LOCKSTEP_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2")) {
+        if (name) *name = "avx512";
+        return lockstep_advance_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        if (name) *name = "avx2";
+        return lockstep_advance_avx2;
+    }
+#endif
+    if (name) *name = "scalar";
+    return lockstep_advance_scalar;
+}
+
+const char *lockstep_kernel_name(void) {
+    const char *name;
+    lockstep_pick_kernel(&name);
+    return name;
+}
+
+bool lockstep_play_range(const Board *b, Rng *rng, int first_game, int num_games, int max_steps, BatchResult *res, TraceSink *trace) {
+    if (!b || !b->next_cell || !rng || !res || !res->conn_counts || max_steps <= 0 || res->max_steps != max_steps) return false;
+
+    LockstepTable t = {
+        .next_cell = b->next_cell,
+        .next_conn = b->next_conn,
+        .die_sides = b->die_sides,
+        .last = b->total_cells - 1,
+        .max_steps = max_steps,
+    };
+    LockstepAdvance advance = lockstep_pick_kernel(NULL);
+    if ((size_t)(b->total_cells + 1) * (size_t)b->die_sides > INT_MAX) {
+        advance = lockstep_advance_scalar; // gathers use 32-bit indices
+    }
+
+    LockstepLanes L;
+    Rng start[LOCKSTEP_LANES]; // lane state when its current game began
+    int game[LOCKSTEP_LANES];
+    uint32_t active = 0;
+    int next_game = first_game;
+    int end_game = first_game + num_games;
+
+    for (int l = 0; l < LOCKSTEP_LANES; ++l) {
+        rng_split(rng, &start[l]);
+        lane_set_rng(&L, l, &start[l]);
+        L.pos[l] = -1;
+        L.rolls[l] = 0;
+        L.hits[l] = 0;
+        game[l] = -1;
+        if (next_game < end_game) {
+            game[l] = next_game++;
+            active |= 1u << l;
+        }
+    }
+
+    bool improved = false;
+    Rng best_start = start[0];
+    while (active) {
+        uint32_t done = advance(&L, &t, active, res->conn_counts);
+        while (done) {
+            int l = __builtin_ctz(done);
+            done &= done - 1;
+
+            int rolls = L.rolls[l];
+            INSTR_ADD(moves, rolls);
+            if (trace) trace_record(trace, game[l], L.pos[l] == t.last ? rolls : 0, L.hits[l], &start[l]);
+            res->games++;
+            if (L.pos[l] == t.last) {
+                res->wins++;
+                res->sum_rolls += rolls;
+                res->hist[rolls]++;
+                // lanes finish out of order, so ties go explicitly to the lower game index
+                if (rolls < res->best_rolls || (rolls == res->best_rolls && game[l] < res->best_game)) {
+                    res->best_rolls = rolls;
+                    res->best_game = game[l];
+                    best_start = start[l];
+                    improved = true;
+                }
+            } else {
+                res->timeouts++;
+                INSTR_ADD(timeouts, 1);
+                simulator_uncount_game(b, &start[l], max_steps, res->conn_counts);
+            }
+
+            // refill the lane with the next game of the range
+            start[l] = lane_rng(&L, l);
+            L.pos[l] = -1;
+            L.rolls[l] = 0;
+            L.hits[l] = 0;
+            if (next_game < end_game) {
+                game[l] = next_game++;
+            } else {
+                game[l] = -1;
+                active &= ~(1u << l);
+            }
+        }
+    }
+
+    // replay the fastest game from its start state to recover the rolls
+    return !improved || simulator_replay_best(b, &best_start, res);
+}
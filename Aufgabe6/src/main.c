@@ -4,23 +4,71 @@
 #include <time.h>
 #include <errno.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <math.h>
+#include <limits.h>
 #include <time.h>
 #include "board.h"
 #include "simulator.h"
+#include "markov.h"
+#include "board_io.h"
+#include "sweep.h"
+#include "designer.h"
+#include "multiplayer.h"
+#include "instrument.h"
+#include "shard.h"
+#include "lockstep.h"
+
+static void print_board_rows(int rows, int columns, int die_sides, int roll_limit, int num_snakes) {
+    printf("| Board size: %5d x %-5d      |\n", rows, columns);
+    printf("| Dice size:  %5d              |\n", die_sides);
+    printf("| Dice roll limit: %5d         |\n", roll_limit);
+    printf("| Snakes & Ladders: %3d          |\n", num_snakes);
+    puts("+--------------------------------+");
+}
 
 static void print_statistics(int sample_size, int rows, int columns, int die_sides, int roll_limit, int num_snakes) {
     puts("+--------------------------------+");
     puts("|     Simulation statistics      |");
     puts("+--------------------------------+");
     printf("| Sample size: %5d            |\n", sample_size);
-    printf("| Board size: %5d x %-5d      |\n", rows, columns);
-    printf("| Dice size:  %5d              |\n", die_sides);
-    printf("| Dice roll limit: %5d         |\n", roll_limit);
-    printf("| Snakes & Ladders: %3d          |\n", num_snakes);
+    print_board_rows(rows, columns, die_sides, roll_limit, num_snakes);
+}
+
+// header of the modes that solve the board instead of sampling games
+static void print_board_statistics(int rows, int columns, int die_sides, int roll_limit, int num_snakes) {
     puts("+--------------------------------+");
+    puts("|        Board statistics        |");
+    puts("+--------------------------------+");
+    print_board_rows(rows, columns, die_sides, roll_limit, num_snakes);
 }
 
-static void print_results(double avg_rolls, int fastest_id, int fastest_rolls, int *fastest_path, int fastest_len, Board *board, long *connection_counts) {
+// fewest possible rolls next to the sampled fastest game
+static void print_shortest(const Board *board) {
+    int *path = NULL;
+    int rolls = board_shortest_path(board, &path);
+    if (rolls < 0) {
+        puts("| Shortest possible: unreachable |");
+        return;
+    }
+    printf("| Shortest possible: %3d rolls   |\n|   ", rolls);
+    for (int i = 0; path && i < rolls; ++i) {
+        printf("%d%s", path[i], (i+1<rolls) ? " -> " : "");
+    }
+    printf("                  |\n");
+    free(path);
+}
+
+static void print_results(const BatchResult *res, Board *board) {
+    int fastest_id = res->best_game + 1;
+    int fastest_rolls = res->best_rolls;
+    const int *fastest_path = res->best_path;
+    int fastest_len = res->best_len;
+    const long *connection_counts = res->conn_counts;
+    BatchSummary sum;
+    batch_result_summary(res, &sum);
+
     int total_snakes = 0;
     int total_ladders = 0;
 
@@ -33,7 +81,12 @@ static void print_results(double avg_rolls, int fastest_id, int fastest_rolls, i
         }
     }
 
-    printf("| Average rolls to win: %8.4f |\n", avg_rolls);
+    printf("| Games won: %10d / %-8d |\n", res->wins, res->games);
+    printf("| Timeouts:  %10d            |\n", res->timeouts);
+    printf("| Average rolls to win: %8.4f |\n", sum.mean);
+    printf("| 95%% CI of mean:   +- %8.4f |\n", sum.ci95);
+    printf("| Standard deviation:   %8.4f |\n", sqrt(sum.variance));
+    printf("| Rolls p50/p95/p99: %4d/%4d/%4d |\n", sum.p50, sum.p95, sum.p99);
     puts("| Fastest simulation:            |");
     printf("|   # %3d with %3d rolls         |\n",
            fastest_id, fastest_rolls);
@@ -41,7 +94,9 @@ static void print_results(double avg_rolls, int fastest_id, int fastest_rolls, i
     for (int i = 0; i < fastest_len; ++i) {
         printf("%d%s", fastest_path[i], (i+1<fastest_len) ? " -> " : "");
     }
-    printf("                  |\n\n");
+    printf("                  |\n");
+    print_shortest(board);
+    printf("\n");
 
     puts("| Snakes & Ladders traversal counts:         |");
     puts("+--------------------------------------------+");
@@ -54,7 +109,7 @@ static void print_results(double avg_rolls, int fastest_id, int fastest_rolls, i
     }
 
     int idx_s = 1; //index snake
-    idx_l = 1; //index ladders
+    int idx_l = 1; //index ladders
     for (int i = 0; i < board->num_connections; ++i) {
         Connection *c = &board->connections[i];
         if (c->is_ladder) {
@@ -70,40 +125,318 @@ static void print_results(double avg_rolls, int fastest_id, int fastest_rolls, i
     puts("+--------------------------------------------+");
 }
 
+// non-empty bins of the game-length histogram
+static void print_histogram(const BatchResult *res) {
+    puts("| Game length histogram:         |");
+    puts("+--------------------------------+");
+    for (int r = 0; r <= res->max_steps; ++r) {
+        if (res->hist[r] == 0) continue;
+        printf("| %5d rolls: %10ld games    |\n", r, res->hist[r]);
+    }
+    puts("+--------------------------------+");
+}
+
+static void print_exact(const MarkovResult *res, int roll_limit, double micros) {
+    puts("|     Exact (Markov chain)       |");
+    puts("+--------------------------------+");
+    printf("| Expected rolls to win: %7.4f |\n", res->expected_rolls);
+    printf("| Standard deviation:   %8.4f |\n", sqrt(res->variance));
+    printf("| P(win in %5d rolls): %7.5f |\n", roll_limit, res->win_probability);
+    printf("| Mean of wins in limit: %7.4f |\n", res->expected_within_limit);
+    if (res->non_terminating > 0) printf("| Non-terminating cells: %7d |\n", res->non_terminating);
+    printf("| Solved in %12.1f us      |\n", micros);
+    puts("+--------------------------------+");
+}
+
+/* Parses a sweep range "first:last[:step]" or a single value into r,
+ * all values within min .. max
+ */
+static bool parse_range(const char *arg, int min, int max, SweepRange *r) {
+    char *endptr;
+    errno = 0;
+    long first = strtol(arg, &endptr, 10), last = first, step = 1;
+    if (*endptr == ':') {
+        last = strtol(endptr + 1, &endptr, 10);
+        if (*endptr == ':') step = strtol(endptr + 1, &endptr, 10);
+    }
+    if (errno || endptr == arg || *endptr != '\0' || first < min || last > max ||
+        first > last || step < 1 || step > INT_MAX) {
+        return false;
+    }
+    r->first = (int)first;
+    r->last = (int)last;
+    r->step = (int)step;
+    return true;
+}
+
+// one line per configuration of the sweep
+static void print_sweep(const SweepRow *rows, int count, int sample_size, int roll_limit, int num_connections) {
+    puts("+---------------------------------------------------------------------------------+");
+    printf("| Sweep: %8d games per configuration, limit %6d rolls, %4d connections      |\n",
+           sample_size, roll_limit, num_connections);
+    puts("+-------+-------+------+-------+----------+-----------+----------+-----------------+");
+    puts("|  rows |  cols |  die | exact | timeouts | mean      | 95% CI   | p50/p95/p99     |");
+    puts("+-------+-------+------+-------+----------+-----------+----------+-----------------+");
+    for (int i = 0; i < count; ++i) {
+        const SweepRow *row = &rows[i];
+        printf("| %5d | %5d | %4d | %5d |", row->rows, row->cols, row->die_sides, row->exact_finish);
+        if (!row->valid) {
+            puts(" connections do not fit this board                |");
+            continue;
+        }
+        BatchSummary sum;
+        batch_result_summary(&row->result, &sum);
+        if (row->result.wins == 0) {
+            printf(" %8d | no game won                            |\n", row->result.timeouts);
+            continue;
+        }
+        printf(" %8d | %9.4f | %8.4f | %4d/%4d/%5d |\n",
+               row->result.timeouts, sum.mean, sum.ci95, sum.p50, sum.p95, sum.p99);
+    }
+    puts("+-------+-------+------+-------+----------+-----------+----------+-----------------+");
+}
+
+// win probability per seat and game length in rounds
+static void print_multiplayer(const MultiResult *res, bool show_histogram) {
+    BatchSummary sum;
+    multi_result_summary(res, &sum);
+    puts("|     Multiplayer                |");
+    puts("+--------------------------------+");
+    printf("| Players: %5d                 |\n", res->num_players);
+    printf("| Games:  %10d             |\n", res->games);
+    printf("| Timeouts: %8d             |\n", res->timeouts);
+    printf("| Average rounds:      %9.4f |\n", sum.mean);
+    printf("| 95%% CI of mean:    +- %8.4f |\n", sum.ci95);
+    printf("| Rounds p50/95/99: %3d/%3d/%3d  |\n", sum.p50, sum.p95, sum.p99);
+    puts("+--------------------------------+");
+    puts("| Seat | P(win)  | 95% CI        |");
+    for (int p = 0; p < res->num_players; ++p) {
+        double pw = (double)res->seat_wins[p] / res->games;
+        printf("| %4d | %7.5f | +- %9.5f  |\n", p + 1, pw, 1.96 * sqrt(pw * (1.0 - pw) / res->games));
+    }
+    puts("+--------------------------------+");
+    if (!show_histogram) return;
+    puts("| Game length histogram:         |");
+    puts("+--------------------------------+");
+    for (int r = 0; r <= res->max_rounds; ++r) {
+        if (res->round_hist[r] == 0) continue;
+        printf("| %5d rounds: %10ld games   |\n", r, res->round_hist[r]);
+    }
+    puts("+--------------------------------+");
+}
+
+// simulates (or solves) one board and prints the report; shard_out saves the result of the shard
+static int run_board(Board *board, int sample_size, int roll_limit, const BatchOptions *options, bool exact_mode, bool show_histogram, int num_players, const char *shard_out) {
+    board_build_graph(board);
+
+    if (num_players > 1) {
+        // -l limits the rounds, every player rolls once per round
+        MultiResult multi;
+        if (!multi_run_batch(board, sample_size, num_players, roll_limit, options, &multi)) {
+            fprintf(stderr, "Multiplayer simulation error\n");
+            return EXIT_FAILURE;
+        }
+        print_statistics(multi.games, board->rows, board->cols, board->die_sides, roll_limit, board->num_connections);
+        print_multiplayer(&multi, show_histogram);
+        multi_result_free(&multi);
+        return EXIT_SUCCESS;
+    }
+
+    if (exact_mode) {
+        MarkovResult exact;
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        bool solved = markov_solve(board, roll_limit, &exact);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (!solved) {
+            fprintf(stderr, "Exact solution failed\n");
+            return EXIT_FAILURE;
+        }
+        double micros = (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+        print_board_statistics(board->rows, board->cols, board->die_sides, roll_limit, board->num_connections);
+        print_exact(&exact, roll_limit, micros);
+        print_shortest(board);
+        return EXIT_SUCCESS;
+    }
+
+    BatchResult result;
+    bool ok = simulator_run_batch(board, sample_size, roll_limit, options, &result);
+    if (!ok) {
+        fprintf(stderr, "No game won or simulation error\n");
+        return EXIT_FAILURE;
+    }
+
+    print_statistics(result.games, board->rows, board->cols, board->die_sides, roll_limit, board->num_connections);
+    if (options->engine == SIM_ENGINE_LOCKSTEP) {
+        // which SIMD path the lockstep engine picked on this CPU
+        printf("| Lockstep kernel: %-13s |\n", lockstep_kernel_name());
+        puts("+--------------------------------+");
+    }
+    print_results(&result, board);
+    if (show_histogram) {
+        print_histogram(&result);
+    }
+    int status = EXIT_SUCCESS;
+    if (shard_out) {
+        ShardInfo info = {
+            .shard_index = options->shard_index,
+            .shard_count = options->shard_count > 0 ? options->shard_count : 1,
+            .num_games = sample_size,
+            .max_steps = roll_limit,
+            .engine = options->engine,
+            .seed = options->seed,
+        };
+        if (!shard_save(shard_out, &info, board, &result)) {
+            fprintf(stderr, "Error: writing shard file %s failed\n", shard_out);
+            status = EXIT_FAILURE;
+        }
+    }
+    batch_result_free(&result);
+    return status;
+}
+
+// `merge [--hist] files...`: adds up the shard files of one run and prints its report
+static int run_merge(int count, char **args) {
+    bool show_histogram = false;
+    if (count > 0 && strcmp(args[0], "--hist") == 0) {
+        show_histogram = true;
+        ++args;
+        --count;
+    }
+    if (count < 1) {
+        fprintf(stderr, "Usage: merge [--hist] shard-file...\n");
+        return EXIT_FAILURE;
+    }
+
+    ShardInfo info;
+    Board *board = NULL;
+    BatchResult result;
+    if (!shard_merge((const char *const *)args, count, &info, &board, &result)) {
+        fprintf(stderr, "Error: merging the shard files failed\n");
+        return EXIT_FAILURE;
+    }
+    if (count < info.shard_count) {
+        fprintf(stderr, "Warning: %d of %d shards merged, %d of %d games\n",
+                count, info.shard_count, result.games, info.num_games);
+    }
+    int status = EXIT_SUCCESS;
+    if (result.wins == 0) {
+        fprintf(stderr, "No game won\n");
+        status = EXIT_FAILURE;
+    } else {
+        board_build_graph(board);
+        print_statistics(result.games, board->rows, board->cols, board->die_sides, info.max_steps, board->num_connections);
+        print_results(&result, board);
+        if (show_histogram) {
+            print_histogram(&result);
+        }
+    }
+    batch_result_free(&result);
+    destroy_board(board);
+    return status;
+}
+
 int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "merge") == 0) {
+        return run_merge(argc - 2, argv + 2);
+    }
+
     int rows = 10, cols = 10;
     int die_sides = 6;
     int sample_size = 1000;
     int roll_limit = 1000;
-    int best_game = -1; // index of the best game (for the fastest path)
+    int num_threads = 1;
+    int num_players = 1; // > 1 plays k-player games with turn order
+    bool verbose = false; // print the instrumentation counters at the end
+    const char *trace_path = NULL; // per-game records of the simulated batches
+    TraceFormat trace_format = TRACE_BINARY;
+    const char *checkpoint_path = NULL; // state after every round, for --resume
+    int checkpoint_every = 0;
+    bool resume = false;
+    int shard_index = 0, shard_count = 0; // --shard i/N, 0 = the whole run
+    const char *shard_out = NULL;
+    uint64_t seed = 1; // fixed default so runs are reproducible
     bool exact_finish = true ; // true means players must land exactly on the last cell to win
+    bool exact_mode = false; // solve the Markov chain instead of simulating
+    SimEngine engine = SIM_ENGINE_SCALAR;
+    double target_ci = 0.0; // 0 = always play sample_size games
+    bool show_histogram = false;
+    const char *board_path = NULL; // boards from a file instead of -w/-h/-d/-e/-s
+    const char *save_path = NULL;  // write the boards as a board file and exit
+    bool save_text = false;        // --save-format text instead of the binary form
+    // sweep mode: ranges replace -w/-h/-d/-e, single values by default
+    bool sweep_mode = false;
+    SweepRange sweep_cols = {0, 0, 1}, sweep_rows = {0, 0, 1};
+    SweepRange sweep_dice = {0, 0, 1}, sweep_exact = {0, 0, 1};
+    bool sweep_cols_set = false, sweep_rows_set = false;
+    bool sweep_dice_set = false, sweep_exact_set = false;
+    // designer mode: search connections for a target mean (and stddev) of the game length
+    bool design_mode = false;
+    double design_mean = 0.0, design_stddev = 0.0;
+    int design_connections = 10;
+    int design_iterations = 20000;
 
-    // storage for up to 32 -s pairs
+    // storage for the -s pairs, grows geometrically
     int max_pairs = 32;
     int (*pairs)[2] = malloc(sizeof(*pairs) * max_pairs);
     int pair_count = 0;
+    if (!pairs) {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+
+    enum { OPT_SEED = 256, OPT_EXACT, OPT_ENGINE, OPT_TARGET_CI, OPT_HIST, OPT_BOARD, OPT_SAVE_BOARD,
+           OPT_SWEEP_W, OPT_SWEEP_H, OPT_SWEEP_D, OPT_SWEEP_E,
+           OPT_DESIGN, OPT_DESIGN_K, OPT_DESIGN_ITERS, OPT_TRACE, OPT_TRACE_FORMAT,
+           OPT_CHECKPOINT, OPT_CHECKPOINT_EVERY, OPT_RESUME, OPT_SHARD, OPT_SHARD_OUT,
+           OPT_SAVE_FORMAT };
+    static const struct option long_options[] = {
+        {"seed", required_argument, NULL, OPT_SEED},
+        {"exact", no_argument, NULL, OPT_EXACT},
+        {"engine", required_argument, NULL, OPT_ENGINE},
+        {"target-ci", required_argument, NULL, OPT_TARGET_CI},
+        {"hist", no_argument, NULL, OPT_HIST},
+        {"board", required_argument, NULL, OPT_BOARD},
+        {"save-board", required_argument, NULL, OPT_SAVE_BOARD},
+        {"save-format", required_argument, NULL, OPT_SAVE_FORMAT},
+        {"sweep-w", required_argument, NULL, OPT_SWEEP_W},
+        {"sweep-h", required_argument, NULL, OPT_SWEEP_H},
+        {"sweep-d", required_argument, NULL, OPT_SWEEP_D},
+        {"sweep-e", required_argument, NULL, OPT_SWEEP_E},
+        {"design", required_argument, NULL, OPT_DESIGN},
+        {"design-k", required_argument, NULL, OPT_DESIGN_K},
+        {"design-iters", required_argument, NULL, OPT_DESIGN_ITERS},
+        {"trace", required_argument, NULL, OPT_TRACE},
+        {"trace-format", required_argument, NULL, OPT_TRACE_FORMAT},
+        {"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+        {"checkpoint-every", required_argument, NULL, OPT_CHECKPOINT_EVERY},
+        {"resume", no_argument, NULL, OPT_RESUME},
+        {"shard", required_argument, NULL, OPT_SHARD},
+        {"shard-out", required_argument, NULL, OPT_SHARD_OUT},
+        {NULL, 0, NULL, 0}
+    };
 
     int opt;
-    while ((opt = getopt(argc, argv, "w:h:d:n:l:s:e:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "w:h:d:n:l:s:e:t:p:v", long_options, NULL)) != -1) {
         char *endptr;
         long val;
 
         switch (opt) {
-            case 'w':  // columns, must be 1–10
+            case 'w':  // columns, the board size is checked after parsing
                 errno = 0;
                 val = strtol(optarg, &endptr, 10);
-                if (errno || *endptr != '\0' || val < 1 || val > 10) {
-                    fprintf(stderr, "Error: -w requires an integer 1–10 (got '%s')\n", optarg);
+                if (errno || *endptr != '\0' || val < 1 || val > INT_MAX) {
+                    fprintf(stderr, "Error: -w requires a positive integer (got '%s')\n", optarg);
                     return EXIT_FAILURE;
                 }
                 cols = (int)val;
                 break;
 
-            case 'h':  // rows, must be 1–10
+            case 'h':  // rows, the board size is checked after parsing
                 errno = 0;
                 val = strtol(optarg, &endptr, 10);
-                if (errno || *endptr != '\0' || val < 1 || val > 10) {
-                    fprintf(stderr, "Error: -h requires an integer 1–10 (got '%s')\n", optarg);
+                if (errno || *endptr != '\0' || val < 1 || val > INT_MAX) {
+                    fprintf(stderr, "Error: -h requires a positive integer (got '%s')\n", optarg);
                     return EXIT_FAILURE;
                 }
                 rows = (int)val;
@@ -112,8 +445,8 @@ int main(int argc, char *argv[]) {
             case 'd':
                 errno = 0;
                 val = strtol(optarg, &endptr, 10);
-                if (errno || *endptr != '\0' || val < 1 || val > 10) {
-                    fprintf(stderr, "Error: -d requires an integer 1–10 (got '%s')\n", optarg);
+                if (errno || *endptr != '\0' || val < 1 || val > INT_MAX) {
+                    fprintf(stderr, "Error: -d requires a positive integer (got '%s')\n", optarg);
                     return EXIT_FAILURE;
                 }
                 die_sides = (int)val;
@@ -138,15 +471,20 @@ int main(int argc, char *argv[]) {
                 break;
 
             case 's':
-                 if (pair_count >= max_pairs) {
-                fprintf(stderr, "Error: Too many -s pairs (max %d)\n", max_pairs);
-                return EXIT_FAILURE;
+                if (pair_count == max_pairs) {
+                    max_pairs *= 2;
+                    int (*grown)[2] = realloc(pairs, sizeof(*pairs) * max_pairs);
+                    if (!grown) {
+                        perror("realloc");
+                        return EXIT_FAILURE;
+                    }
+                    pairs = grown;
                 }
                 // parse start
                 char *arg1 = optarg;
                 errno = 0;
                 long start = strtol(arg1, &endptr, 10);
-                if (errno || *endptr != '\0') {
+                if (errno || *endptr != '\0' || start < INT_MIN || start > INT_MAX) {
                     fprintf(stderr, "Error: -s start must be an integer (got '%s')\n", arg1);
                     return EXIT_FAILURE;
                 }
@@ -159,22 +497,12 @@ int main(int argc, char *argv[]) {
                 char *arg2 = argv[optind++];
                 errno = 0;
                 long end = strtol(arg2, &endptr, 10);
-                if (errno || *endptr != '\0') {
+                if (errno || *endptr != '\0' || end < INT_MIN || end > INT_MAX) {
                     fprintf(stderr, "Error: -s end must be an integer (got '%s')\n", arg2);
                     return EXIT_FAILURE;
                 }
 
-                // range check
-                int target = rows * cols - 1;
-                if (start < 0 || start > target ||
-                    end   < 0 || end   > target) {
-                    fprintf(stderr,
-                        "Error: -s values must be between 0 and %d (got %ld->%ld)\n",
-                        target, start, end);
-                    return EXIT_FAILURE;
-                }
-
-                // no self-loop
+                // no self-loop; the range is checked once the board size is known
                 if (start == end) {
                     fprintf(stderr,
                         "Error: -s start and end must differ (%ld->%ld)\n",
@@ -182,14 +510,6 @@ int main(int argc, char *argv[]) {
                     return EXIT_FAILURE;
                 }
 
-                // no snake on final square
-                if (start == target && end < start) {
-                    fprintf(stderr,
-                        "Error: cannot place a snake on the final square (%ld->%ld)\n",
-                        start, end);
-                    return EXIT_FAILURE;
-                }
-
                 // everything OK: save pair
                 pairs[pair_count][0] = (int)start;
                 pairs[pair_count][1] = (int)end;
@@ -206,17 +526,376 @@ int main(int argc, char *argv[]) {
                 exact_finish = (val == 1);
                 break;
 
+            case 't':  // number of worker threads
+                errno = 0;
+                val = strtol(optarg, &endptr, 10);
+                if (errno || *endptr != '\0' || val < 1 || val > 1024) {
+                    fprintf(stderr, "Error: -t requires an integer 1–1024 (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                num_threads = (int)val;
+                break;
+
+            case 'p':  // players per game, taking turns in seat order
+                errno = 0;
+                val = strtol(optarg, &endptr, 10);
+                if (errno || *endptr != '\0' || val < 1 || val > 1024) {
+                    fprintf(stderr, "Error: -p requires an integer 1–1024 (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                num_players = (int)val;
+                break;
+
+            case 'v':
+                verbose = true;
+                break;
+
+            case OPT_SEED: {
+                errno = 0;
+                unsigned long long seed_val = strtoull(optarg, &endptr, 0);
+                if (errno || *endptr != '\0' || optarg[0] == '-' || optarg[0] == '\0') {
+                    fprintf(stderr, "Error: --seed requires a non-negative integer (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                seed = (uint64_t)seed_val;
+                break;
+            }
+
+            case OPT_EXACT:
+                exact_mode = true;
+                break;
+
+            case OPT_ENGINE:
+                if (strcmp(optarg, "scalar") == 0) {
+                    engine = SIM_ENGINE_SCALAR;
+                } else if (strcmp(optarg, "lockstep") == 0) {
+                    engine = SIM_ENGINE_LOCKSTEP;
+                } else {
+                    fprintf(stderr, "Error: --engine requires scalar or lockstep (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case OPT_TARGET_CI:  // stop once the 95% CI of the mean is this tight, -n is the maximum
+                errno = 0;
+                target_ci = strtod(optarg, &endptr);
+                if (errno || *endptr != '\0' || !(target_ci > 0.0)) {
+                    fprintf(stderr, "Error: --target-ci requires a positive number (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case OPT_HIST:
+                show_histogram = true;
+                break;
+
+            case OPT_BOARD:
+                board_path = optarg;
+                break;
+
+            case OPT_SAVE_BOARD:
+                save_path = optarg;
+                break;
+
+            case OPT_SAVE_FORMAT:
+                if (strcmp(optarg, "binary") == 0) {
+                    save_text = false;
+                } else if (strcmp(optarg, "text") == 0) {
+                    save_text = true;
+                } else {
+                    fprintf(stderr, "Error: --save-format requires binary or text (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case OPT_SWEEP_W:  // first:last[:step], like the other sweep ranges
+                if (!parse_range(optarg, 1, INT_MAX, &sweep_cols)) {
+                    fprintf(stderr, "Error: --sweep-w requires a range first:last[:step] of positive integers (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                sweep_mode = sweep_cols_set = true;
+                break;
+
+            case OPT_SWEEP_H:
+                if (!parse_range(optarg, 1, INT_MAX, &sweep_rows)) {
+                    fprintf(stderr, "Error: --sweep-h requires a range first:last[:step] of positive integers (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                sweep_mode = sweep_rows_set = true;
+                break;
+
+            case OPT_SWEEP_D:
+                if (!parse_range(optarg, 1, INT_MAX, &sweep_dice)) {
+                    fprintf(stderr, "Error: --sweep-d requires a range first:last[:step] of positive integers (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                sweep_mode = sweep_dice_set = true;
+                break;
+
+            case OPT_SWEEP_E:
+                if (!parse_range(optarg, 0, 1, &sweep_exact)) {
+                    fprintf(stderr, "Error: --sweep-e requires 0, 1 or 0:1 (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                sweep_mode = sweep_exact_set = true;
+                break;
+
+            case OPT_DESIGN:  // mean[:stddev]
+                errno = 0;
+                design_mean = strtod(optarg, &endptr);
+                design_stddev = 0.0;
+                if (*endptr == ':') design_stddev = strtod(endptr + 1, &endptr);
+                if (errno || *endptr != '\0' || !(design_mean > 0.0) || !(design_stddev >= 0.0)) {
+                    fprintf(stderr, "Error: --design requires mean[:stddev] with mean > 0 (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                design_mode = true;
+                break;
+
+            case OPT_DESIGN_K:
+                errno = 0;
+                val = strtol(optarg, &endptr, 10);
+                if (errno || *endptr != '\0' || val < 0 || val > INT_MAX / 2) {
+                    fprintf(stderr, "Error: --design-k requires a non-negative integer (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                design_connections = (int)val;
+                break;
+
+            case OPT_DESIGN_ITERS:
+                errno = 0;
+                val = strtol(optarg, &endptr, 10);
+                if (errno || *endptr != '\0' || val < 0 || val > INT_MAX) {
+                    fprintf(stderr, "Error: --design-iters requires a non-negative integer (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                design_iterations = (int)val;
+                break;
+
+            case OPT_TRACE:
+                trace_path = optarg;
+                break;
+
+            case OPT_TRACE_FORMAT:
+                if (strcmp(optarg, "binary") == 0) {
+                    trace_format = TRACE_BINARY;
+                } else if (strcmp(optarg, "csv") == 0) {
+                    trace_format = TRACE_CSV;
+                } else {
+                    fprintf(stderr, "Error: --trace-format requires binary or csv (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case OPT_CHECKPOINT:
+                checkpoint_path = optarg;
+                break;
+
+            case OPT_CHECKPOINT_EVERY:  // games per round, a checkpoint follows every round
+                errno = 0;
+                val = strtol(optarg, &endptr, 10);
+                if (errno || *endptr != '\0' || val < 1 || val > INT_MAX) {
+                    fprintf(stderr, "Error: --checkpoint-every requires a positive integer (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                checkpoint_every = (int)val;
+                break;
+
+            case OPT_RESUME:
+                resume = true;
+                break;
+
+            case OPT_SHARD: {  // i/N, 0-based shard index
+                long count;
+                errno = 0;
+                val = strtol(optarg, &endptr, 10);
+                bool valid = !errno && endptr != optarg && *endptr == '/';
+                if (valid) {
+                    char *index_end = endptr + 1;
+                    count = strtol(index_end, &endptr, 10);
+                    valid = !errno && endptr != index_end && *endptr == '\0' &&
+                            count >= 1 && count <= INT_MAX && val >= 0 && val < count;
+                }
+                if (!valid) {
+                    fprintf(stderr, "Error: --shard requires i/N with 0 <= i < N (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                shard_index = (int)val;
+                shard_count = (int)count;
+                break;
+            }
+
+            case OPT_SHARD_OUT:
+                shard_out = optarg;
+                break;
+
             default:
-                fprintf(stderr, "Usage: %s [-w 1-10] [-h 1-10] [-d 1-10] [-n ≥1] [-l ≥1] [-e 0|1] [-s start end]...\n", argv[0]);
+                fprintf(stderr, "Usage: %s [-w ≥1] [-h ≥1] [-d ≥1] [-n ≥1] [-l ≥1] [-e 0|1] [-t threads] [-p players] [-v] [--seed n] [--exact] [--engine scalar|lockstep] [--target-ci x] [--hist] [--board file] [--save-board file] [--save-format binary|text] [--sweep-w a:b[:step]] [--sweep-h a:b[:step]] [--sweep-d a:b[:step]] [--sweep-e a:b] [--design mean[:stddev]] [--design-k n] [--design-iters n] [--trace file] [--trace-format binary|csv] [--checkpoint file] [--checkpoint-every n] [--resume] [--shard i/N] [--shard-out file] [-s start end]...\n"
+                                "       %s merge [--hist] shard-file...\n", argv[0], argv[0]);
                 return EXIT_FAILURE;
         }
     }
 
-    // Validate board dimensions one more time
-    if (rows < 1 || rows > 10 || cols < 1 || cols > 10) {
+    if ((shard_count > 0 || shard_out) &&
+        (exact_mode || target_ci > 0.0 || sweep_mode || design_mode || num_players > 1)) {
+        fprintf(stderr, "Error: --shard and --shard-out cannot be combined with --exact, --target-ci, --sweep, --design or -p\n");
+        free(pairs);
+        return EXIT_FAILURE;
+    }
+    // shards are made of whole blocks of games (see simulator.h)
+    int num_blocks = (sample_size - 1) / simulator_block_games(sample_size) + 1;
+    if (shard_count > num_blocks) {
+        fprintf(stderr, "Error: --shard needs at least one block per shard (%d shards, -n %d gives %d blocks)\n",
+                shard_count, sample_size, num_blocks);
+        free(pairs);
+        return EXIT_FAILURE;
+    }
+
+    if (num_players > 1 && (exact_mode || target_ci > 0.0 || sweep_mode || design_mode ||
+                            trace_path || checkpoint_path || checkpoint_every > 0 || resume)) {
+        fprintf(stderr, "Error: -p cannot be combined with --exact, --target-ci, --sweep, --design, --trace, --checkpoint or --resume\n");
+        free(pairs);
+        return EXIT_FAILURE;
+    }
+
+    // only the simulated batches are traced
+    if (trace_path && (exact_mode || sweep_mode || design_mode)) {
+        fprintf(stderr, "Error: --trace cannot be combined with --exact, --sweep or --design\n");
+        free(pairs);
+        return EXIT_FAILURE;
+    }
+    if ((checkpoint_path || checkpoint_every > 0 || resume) && (exact_mode || sweep_mode || design_mode)) {
+        fprintf(stderr, "Error: --checkpoint, --checkpoint-every and --resume cannot be combined with --exact, --sweep or --design\n");
+        free(pairs);
+        return EXIT_FAILURE;
+    }
+
+    // Designer mode: -t chains search a board of -w/-h/-d/-e, checked and
+    // solved again through the regular board code
+    if (design_mode) {
+        free(pairs);
+        if (sweep_mode || board_path || save_path || pair_count > 0) {
+            fprintf(stderr, "Error: --design cannot be combined with -s, --sweep, --board or --save-board\n");
+            return EXIT_FAILURE;
+        }
+        if ((long long)rows * cols > BOARD_MAX_CELLS) {
+            fprintf(stderr, "Error: board must have 1–%d cells (got %dx%d)\n", BOARD_MAX_CELLS, rows, cols);
+            return EXIT_FAILURE;
+        }
+        DesignSpec spec = {
+            .rows = rows,
+            .cols = cols,
+            .die_sides = die_sides,
+            .exact_finish = exact_finish,
+            .num_connections = design_connections,
+            .target_mean = design_mean,
+            .target_stddev = design_stddev,
+            .iterations = design_iterations,
+            .num_chains = num_threads,
+            .seed = seed,
+        };
+        DesignResult design;
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (!designer_run(&spec, &design)) {
+            fprintf(stderr, "Error: board design failed\n");
+            return EXIT_FAILURE;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double micros = (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+
+        Board *board = create_board_reserved(rows, cols, die_sides, exact_finish, design.num_pairs);
+        bool ok = board != NULL;
+        for (int i = 0; ok && i < design.num_pairs; ++i) {
+            ok = board_add_connection(board, design.pairs[i][0], design.pairs[i][1]);
+        }
+        MarkovResult exact;
+        struct timespec t2;
+        if (ok) {
+            board_build_graph(board);
+            ok = markov_solve(board, roll_limit, &exact);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+        if (!ok) {
+            fprintf(stderr, "Error: designed board failed validation\n");
+            design_result_free(&design);
+            destroy_board(board);
+            return EXIT_FAILURE;
+        }
+
+        print_board_statistics(rows, cols, die_sides, roll_limit, design.num_pairs);
+        puts("|     Board designer             |");
+        puts("+--------------------------------+");
+        printf("| Target mean:          %8.4f |\n", design_mean);
+        if (design_stddev > 0.0) printf("| Target stddev:        %8.4f |\n", design_stddev);
+        printf("| Candidates: %10ld in %d chains |\n", design.evaluations, num_threads);
+        printf("| Searched in %10.1f ms        |\n", micros / 1e3);
+        printf("| %6.2f us per candidate        |\n", design.evaluations ? micros / design.evaluations : 0.0);
+        printf("| Cost (rel. error^2): %9.3g |\n", design.cost);
+        print_exact(&exact, roll_limit, (t2.tv_sec - t1.tv_sec) * 1e6 + (t2.tv_nsec - t1.tv_nsec) / 1e3);
+        printf("Connections:");
+        for (int i = 0; i < design.num_pairs; ++i) {
+            printf(" -s %d %d", design.pairs[i][0], design.pairs[i][1]);
+        }
+        printf("\n");
+        design_result_free(&design);
+        destroy_board(board);
+        return EXIT_SUCCESS;
+    }
+
+    // Sweep mode: the connections are checked per configuration, the table
+    // marks the boards they do not fit
+    if (sweep_mode) {
+        if (board_path || save_path || exact_mode || target_ci > 0.0) {
+            fprintf(stderr, "Error: the --sweep options cannot be combined with --board, --save-board, --exact or --target-ci\n");
+            return EXIT_FAILURE;
+        }
+        if (!sweep_cols_set) sweep_cols = (SweepRange){cols, cols, 1};
+        if (!sweep_rows_set) sweep_rows = (SweepRange){rows, rows, 1};
+        if (!sweep_dice_set) sweep_dice = (SweepRange){die_sides, die_sides, 1};
+        if (!sweep_exact_set) sweep_exact = (SweepRange){exact_finish, exact_finish, 1};
+        SweepSpec spec = {
+            .rows = sweep_rows,
+            .cols = sweep_cols,
+            .die_sides = sweep_dice,
+            .exact_finish = sweep_exact,
+            .pairs = (const int (*)[2])pairs,
+            .num_pairs = pair_count,
+            .num_games = sample_size,
+            .max_steps = roll_limit,
+            .num_threads = num_threads,
+            .seed = seed,
+            .engine = engine,
+        };
+        SweepRow *sweep = NULL;
+        int configs = 0;
+        bool ok = sweep_run(&spec, &sweep, &configs);
+        free(pairs);
+        if (!ok) {
+            fprintf(stderr, "Error: sweep failed\n");
+            return EXIT_FAILURE;
+        }
+        print_sweep(sweep, configs, sample_size, roll_limit, pair_count);
+        sweep_free(sweep, configs);
+        if (verbose) {
+            instr_report(stdout);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Validate board dimensions one more time: every cell and the start
+    // position need an int index
+    if (rows < 1 || cols < 1 || (long long)rows * cols > BOARD_MAX_CELLS) {
         fprintf(stderr,
-            "Error: board dimensions must be 1–10 (got %dx%d)\n",
-            rows, cols);
+            "Error: board must have 1–%d cells (got %dx%d)\n",
+            BOARD_MAX_CELLS, rows, cols);
+        return EXIT_FAILURE;
+    }
+
+    // the pairs belong to the -w/-h board, a board file brings its own
+    if (board_path && pair_count > 0) {
+        fprintf(stderr, "Error: -s cannot be combined with --board\n");
+        free(pairs);
         return EXIT_FAILURE;
     }
 
@@ -244,44 +923,92 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    // Build the board and add all connections
-    Board *board = create_board(rows, cols, die_sides, exact_finish);
-    if (!board) {
-        fprintf(stderr, "Error: Board creation failed\n");
-        return EXIT_FAILURE;
-    }
-    for (int i = 0; i < pair_count; ++i) {
-        if (!board_add_connection(board, pairs[i][0], pairs[i][1])) {
-            fprintf(stderr, "Invalid connection: %d -> %d\n",
-                    pairs[i][0], pairs[i][1]);
+    // Build the board from the command line unless a board file is given
+    BoardSet set = {NULL, 0};
+    if (board_path) {
+        free(pairs);
+        if (!board_file_load(board_path, &set)) {
+            fprintf(stderr, "Error: could not load boards from %s\n", board_path);
+            return EXIT_FAILURE;
+        }
+    } else {
+        Board *board = create_board_reserved(rows, cols, die_sides, exact_finish, pair_count);
+        if (!board) {
+            fprintf(stderr, "Error: Board creation failed\n");
+            return EXIT_FAILURE;
+        }
+        for (int i = 0; i < pair_count; ++i) {
+            if (!board_add_connection(board, pairs[i][0], pairs[i][1])) {
+                fprintf(stderr, "Invalid connection: %d -> %d\n",
+                        pairs[i][0], pairs[i][1]);
+                destroy_board(board);
+                return EXIT_FAILURE;
+            }
+        }
+        free(pairs);
+        set.boards = malloc(sizeof(Board *));
+        if (!set.boards) {
             destroy_board(board);
             return EXIT_FAILURE;
         }
+        set.boards[0] = board;
+        set.count = 1;
     }
-    free(pairs);
 
-    // Run simulations...
-    double avg_rolls;
-    int min_rolls;
-    int *best_path = NULL;
-    int best_len = 0;
-    long *conn_counts = NULL;
+    if (save_path) {
+        bool saved = save_text ? board_file_save_text(save_path, set.boards, set.count)
+                               : board_file_save_binary(save_path, set.boards, set.count);
+        board_set_free(&set);
+        return saved ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    board_build_graph(board);
+    // Run simulations...
+    BatchOptions options = {
+        .num_threads = num_threads,
+        .seed = seed,
+        .engine = engine,
+        .target_ci = target_ci,
+        .checkpoint_path = checkpoint_path,
+        .checkpoint_every = checkpoint_every,
+        .resume = resume,
+        .shard_index = shard_index,
+        .shard_count = shard_count,
+    };
+    if ((resume || checkpoint_every > 0) && !checkpoint_path) {
+        fprintf(stderr, "Error: --resume and --checkpoint-every need --checkpoint file\n");
+        board_set_free(&set);
+        return EXIT_FAILURE;
+    }
+    if ((checkpoint_path || shard_out) && set.count > 1) {
+        fprintf(stderr, "Error: --checkpoint and --shard-out work on a single board\n");
+        board_set_free(&set);
+        return EXIT_FAILURE;
+    }
 
-    bool ok = simulator_run_batch(board, sample_size, roll_limit, &avg_rolls, &min_rolls, &best_path, &best_len, &best_game, &conn_counts);
-    if (!ok) {
-        fprintf(stderr, "No game won or simulation error\n");
-        destroy_board(board);
+    if (trace_path && !(options.trace = trace_open(trace_path, trace_format, num_threads, roll_limit, seed))) {
+        fprintf(stderr, "Error: could not open trace file %s\n", trace_path);
+        board_set_free(&set);
         return EXIT_FAILURE;
     }
 
-    print_statistics(sample_size, rows, cols, die_sides, roll_limit, board->num_connections);
-    print_results(avg_rolls, best_game + 1, min_rolls, best_path, best_len, board, conn_counts);
+    int status = EXIT_SUCCESS;
+    for (int i = 0; i < set.count; ++i) {
+        if (set.count > 1) printf("\nBoard %d of %d\n", i + 1, set.count);
+        trace_set_board(options.trace, i);
+        if (run_board(set.boards[i], sample_size, roll_limit, &options, exact_mode, show_histogram, num_players, shard_out) != EXIT_SUCCESS) {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    if (options.trace && !trace_close(options.trace)) {
+        fprintf(stderr, "Error: writing trace file %s failed\n", trace_path);
+        status = EXIT_FAILURE;
+    }
+    if (verbose) {
+        instr_report(stdout);
+    }
 
     // Cleanup
-    free(best_path);
-    free(conn_counts);
-    destroy_board(board);
-    return EXIT_SUCCESS;
+    board_set_free(&set);
+    return status;
 }
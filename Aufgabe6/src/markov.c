@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "markov.h"
+
+#define MARKOV_MAX_SWEEPS 1000000
+#define MARKOV_TOLERANCE 1e-13
+
+/* Marks in finite the states that reach the last cell with probability 1:
+ * those that can not get to a state from which the last cell is out of
+ * reach. The other states have E[T] = inf. Returns false on allocation failure.
+ */
+static bool markov_finite_states(const int *succ, int num_states, int S, int goal, char *finite) {
+    size_t num_edges = (size_t)num_states * S;
+    bool ok = false;
+    char *can_win = calloc(num_states, 1);
+    int *stack = malloc(sizeof(int) * num_states);
+    size_t *pred_start = calloc((size_t)num_states + 1, sizeof(size_t));
+    int *pred = malloc(sizeof(int) * num_edges);
+    if (!can_win || !stack || !pred_start || !pred) goto out;
+
+    // reverse edges in CSR form: predecessors of n are pred[pred_start[n] .. pred_start[n+1])
+    for (size_t e = 0; e < num_edges; ++e) {
+        pred_start[succ[e] + 1]++;
+    }
+    for (int n = 0; n < num_states; ++n) {
+        pred_start[n + 1] += pred_start[n];
+    }
+    for (size_t e = 0; e < num_edges; ++e) {
+        pred[pred_start[succ[e]]++] = (int)(e / S);
+    }
+    for (int n = num_states; n > 0; --n) {
+        pred_start[n] = pred_start[n - 1];
+    }
+    pred_start[0] = 0;
+
+    // backward search from the goal
+    int top = 0;
+    stack[top++] = goal;
+    can_win[goal] = 1;
+    while (top > 0) {
+        int n = stack[--top];
+        for (size_t i = pred_start[n]; i < pred_start[n + 1]; ++i) {
+            if (!can_win[pred[i]]) {
+                can_win[pred[i]] = 1;
+                stack[top++] = pred[i];
+            }
+        }
+    }
+
+    // backward search from the states that can not win
+    for (int s = 0; s < num_states; ++s) {
+        finite[s] = can_win[s];
+        if (!can_win[s]) stack[top++] = s;
+    }
+    while (top > 0) {
+        int n = stack[--top];
+        for (size_t i = pred_start[n]; i < pred_start[n + 1]; ++i) {
+            if (finite[pred[i]]) {
+                finite[pred[i]] = 0;
+                stack[top++] = pred[i];
+            }
+        }
+    }
+    ok = true;
+
+out:
+    free(can_win);
+    free(stack);
+    free(pred_start);
+    free(pred);
+    return ok;
+}
+
+/* Gauss-Seidel for x = c + Q x with x[goal] = 0, where
+ * c[s] = 1 + sum_r p * (2 * t[succ]) when t is given (second moment), else 1.
+ * Only the finite states are swept: their successors are finite as well, the
+ * others keep x = inf and stay out of the convergence test.
+ */
+static int markov_sweep(const int *succ, int num_states, int S, int goal, const char *finite,
+                        const double *t, double *x) {
+    double p = 1.0 / S;
+    for (int sweep = 1; sweep <= MARKOV_MAX_SWEEPS; ++sweep) {
+        double max_delta = 0.0;
+        double max_value = 1.0;
+        for (int s = num_states - 1; s >= 0; --s) {
+            if (s == goal || !finite[s]) continue;
+            double acc = 1.0;
+            double self = 0.0;
+            for (int r = 0; r < S; ++r) {
+                int n = succ[(size_t)s * S + r];
+                if (t) acc += 2.0 * p * t[n];
+                if (n == s) self += p;
+                else acc += p * x[n];
+            }
+            double value = acc / (1.0 - self);
+            double delta = fabs(value - x[s]);
+            if (delta > max_delta) max_delta = delta;
+            if (value > max_value) max_value = value;
+            x[s] = value;
+        }
+        if (max_delta <= MARKOV_TOLERANCE * max_value) return sweep;
+    }
+    return -1;
+}
+
+bool markov_solve(const Board *b, int roll_limit, MarkovResult *out) {
+    if (!b || !b->next_cell || !out || roll_limit < 0) return false;
+
+    int S = b->die_sides;
+    int num_states = b->total_cells + 1;
+    int goal = b->total_cells; // state of the last cell
+
+    /* states: 0 = before the board, c + 1 = cell c. These are exactly the
+     * rows of the transition table, so succ[s * S + r] + 1 is the next state.
+     */
+    int *succ = malloc(sizeof(int) * (size_t)num_states * S);
+    if (succ) {
+        for (size_t i = 0; i < (size_t)num_states * S; ++i) {
+            succ[i] = b->next_cell[i] + 1;
+        }
+    }
+    double *t = calloc(num_states, sizeof(double));
+    double *m2 = calloc(num_states, sizeof(double));
+    double *dist = calloc(num_states, sizeof(double));
+    double *next = calloc(num_states, sizeof(double));
+    char *finite = malloc(num_states);
+    bool ok = false;
+    if (!succ || !t || !m2 || !dist || !next || !finite ||
+        !markov_finite_states(succ, num_states, S, goal, finite)) {
+        perror("malloc");
+        goto out;
+    }
+
+    if (!finite[0]) {
+        fprintf(stderr, "markov_solve: last cell is not reachable from every position\n");
+        goto out;
+    }
+    int non_terminating = 0;
+    for (int s = 0; s < num_states; ++s) {
+        if (finite[s]) continue;
+        t[s] = INFINITY;
+        m2[s] = INFINITY;
+        non_terminating++;
+    }
+
+    int sweeps_t = markov_sweep(succ, num_states, S, goal, finite, NULL, t);
+    int sweeps_m2 = sweeps_t > 0 ? markov_sweep(succ, num_states, S, goal, finite, t, m2) : -1;
+    if (sweeps_t < 0 || sweeps_m2 < 0) {
+        fprintf(stderr, "markov_solve: no convergence after %d sweeps\n", MARKOV_MAX_SWEEPS);
+        goto out;
+    }
+
+    // distribution of the position after k rolls, the goal mass is moved out
+    double p = 1.0 / S;
+    double won = 0.0;
+    double won_rolls = 0.0;
+    dist[0] = 1.0;
+    for (int k = 1; k <= roll_limit; ++k) {
+        memset(next, 0, sizeof(double) * num_states);
+        for (int s = 0; s < num_states; ++s) {
+            double mass = dist[s];
+            if (mass == 0.0) continue;
+            mass *= p;
+            for (int r = 0; r < S; ++r) {
+                next[succ[(size_t)s * S + r]] += mass;
+            }
+        }
+        won += next[goal];
+        won_rolls += k * next[goal];
+        next[goal] = 0.0;
+
+        double remaining = 0.0;
+        for (int s = 0; s < num_states; ++s) {
+            remaining += next[s];
+        }
+
+        double *tmp = dist;
+        dist = next;
+        next = tmp;
+        if (remaining < 1e-18) break; // rest is below double precision of P(win)
+    }
+
+    out->expected_rolls = t[0];
+    out->variance = m2[0] - t[0] * t[0];
+    out->win_probability = won > 1.0 ? 1.0 : won;
+    out->expected_within_limit = won > 0.0 ? won_rolls / won : 0.0;
+    out->iterations = sweeps_t + sweeps_m2;
+    out->non_terminating = non_terminating;
+    ok = true;
+
+out:
+    free(succ);
+    free(t);
+    free(m2);
+    free(dist);
+    free(next);
+    free(finite);
+    return ok;
+}
+
+/* markov_sweep on the jumps directly; cells with a connection are never
+ * occupied and keep their value
+ */
+static int markov_sweep_jump(int cells, int S, bool exact_finish, const int *jump, const double *t,
+                             double *x, int max_sweeps, double limit) {
+    double p = 1.0 / S;
+    int last = cells - 1;
+    for (int sweep = 1; sweep <= max_sweeps; ++sweep) {
+        double max_delta = 0.0;
+        double max_value = 1.0;
+        for (int s = cells - 1; s >= 0; --s) {
+            int pos = s - 1;
+            if (pos >= 0 && jump[pos] != pos) continue;
+            double acc = 1.0;
+            double self = 0.0;
+            for (int r = 1; r <= S; ++r) {
+                int target = pos + r;
+                if (target > last) target = exact_finish ? pos : last;
+                else target = jump[target];
+                if (t) acc += 2.0 * p * t[target + 1];
+                if (target == pos) self += p;
+                else if (target != last) acc += p * x[target + 1];
+            }
+            double value = acc / (1.0 - self);
+            double delta = fabs(value - x[s]);
+            if (delta > max_delta) max_delta = delta;
+            if (value > max_value) max_value = value;
+            x[s] = value;
+        }
+        if (max_value > limit) return -1;
+        if (max_delta <= MARKOV_TOLERANCE * max_value) return sweep;
+    }
+    return -1;
+}
+
+bool markov_moments(int total_cells, int die_sides, bool exact_finish, const int *jump,
+                    int max_sweeps, double limit, double *t, double *m2,
+                    double *mean, double *variance) {
+    if (total_cells < 1 || die_sides < 1 || !jump || !t || !m2 || !mean || !variance) return false;
+    t[total_cells] = 0.0;
+    m2[total_cells] = 0.0;
+    if (markov_sweep_jump(total_cells, die_sides, exact_finish, jump, NULL, t, max_sweeps, limit) < 0 ||
+        markov_sweep_jump(total_cells, die_sides, exact_finish, jump, t, m2, max_sweeps, limit * limit) < 0) {
+        return false;
+    }
+    *mean = t[0];
+    *variance = m2[0] - t[0] * t[0];
+    return true;
+}
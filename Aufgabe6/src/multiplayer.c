@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "multiplayer.h"
+#include "utils.h"
+#include "instrument.h"
+
+bool multi_result_init(MultiResult *res, int num_players, int max_rounds) {
+    if (!res || num_players < 1 || max_rounds < 0) return false;
+    res->num_players = num_players;
+    res->games = 0;
+    res->timeouts = 0;
+    res->max_rounds = max_rounds;
+    INSTR_ADD(allocs, 2);
+    res->seat_wins = calloc(num_players, sizeof(long));
+    res->round_hist = calloc((size_t)max_rounds + 1, sizeof(long));
+    if (!res->seat_wins || !res->round_hist) {
+        multi_result_free(res);
+        return false;
+    }
+    return true;
+}
+
+void multi_result_free(MultiResult *res) {
+    if (!res) return;
+    free(res->seat_wins);
+    free(res->round_hist);
+    res->seat_wins = NULL;
+    res->round_hist = NULL;
+}
+
+bool multi_result_merge(MultiResult *into, const MultiResult *from) {
+    if (!into || !from || into->num_players != from->num_players ||
+        into->max_rounds != from->max_rounds) {
+        return false;
+    }
+    into->games += from->games;
+    into->timeouts += from->timeouts;
+    for (int p = 0; p < into->num_players; ++p) {
+        into->seat_wins[p] += from->seat_wins[p];
+    }
+    for (int r = 0; r <= into->max_rounds; ++r) {
+        into->round_hist[r] += from->round_hist[r];
+    }
+    return true;
+}
+
+// smallest r such that at least percent % of the won games took <= r rounds
+static int round_percentile(const MultiResult *res, long wins, int percent) {
+    long cum = 0;
+    for (int r = 0; r <= res->max_rounds; ++r) {
+        cum += res->round_hist[r];
+        if (cum * 100 >= (long)percent * wins) return r;
+    }
+    return res->max_rounds;
+}
+
+void multi_result_summary(const MultiResult *res, BatchSummary *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    long wins = res ? res->games - res->timeouts : 0;
+    if (wins <= 0) return;
+
+    long double sum = 0.0L;
+    long double sum_sq = 0.0L;
+    for (int r = 0; r <= res->max_rounds; ++r) {
+        long double c = res->round_hist[r];
+        sum += c * r;
+        sum_sq += c * r * r;
+    }
+    long double n = wins;
+    long double mean = sum / n;
+
+    out->mean = (double)mean;
+    out->variance = wins > 1 ? (double)((sum_sq - sum * mean) / (n - 1)) : 0.0;
+    if (out->variance < 0.0) out->variance = 0.0; // rounding
+    out->ci95 = 1.96 * sqrt(out->variance / wins);
+    out->p50 = round_percentile(res, wins, 50);
+    out->p95 = round_percentile(res, wins, 95);
+    out->p99 = round_percentile(res, wins, 99);
+}
+
+int multi_play_game(const Board *b, Rng *rng, int num_players, int max_rounds, int *positions, int *rounds) {
+    const int *next_cell = b->next_cell;
+    int sides = b->die_sides;
+    int last = b->total_cells - 1;
+
+    for (int p = 0; p < num_players; ++p) {
+        positions[p] = -1;
+    }
+    for (int round = 1; round <= max_rounds; ++round) {
+        // everyone moves, then the lowest seat on the last cell wins
+        int finished = 0;
+        for (int p = 0; p < num_players; ++p) {
+            size_t idx = board_move_index(b, positions[p], roll_die(rng, sides));
+            int pos = next_cell[idx];
+            INSTR_ADD(bounces, pos == positions[p] && b->next_conn[idx] < 0);
+            INSTR_ADD(conn_hits, b->next_conn[idx] >= 0);
+            positions[p] = pos;
+            finished |= pos == last;
+        }
+        if (finished) {
+            INSTR_ADD(moves, (long)round * num_players);
+            int p = 0;
+            while (positions[p] != last) ++p;
+            *rounds = round;
+            return p;
+        }
+    }
+    INSTR_ADD(moves, (long)max_rounds * num_players);
+    INSTR_ADD(timeouts, 1);
+    return -1;
+}
+
+/* share of the blocks of one worker, see BatchWorker in simulator.c;
+ * rng is the stream of its first block
+ */
+typedef struct {
+    const Board *board;
+    int first_block;
+    int num_blocks;
+    int block_games;
+    int num_games;     // of the whole batch, only its last block is shorter
+    int num_players;
+    int max_rounds;
+    Rng rng;
+    bool ok;
+    MultiResult res;
+} MultiWorker;
+
+static void *multi_worker_run(void *arg) {
+    MultiWorker *w = arg;
+    INSTR_CLOCK(t0);
+    INSTR_ADD(allocs, 1);
+    int *positions = malloc(sizeof(int) * w->num_players);
+    if (!positions) {
+        w->ok = false;
+        return NULL;
+    }
+    for (int k = w->first_block; k < w->first_block + w->num_blocks; ++k) {
+        int first_game = k * w->block_games;
+        int n = w->num_games - first_game < w->block_games ? w->num_games - first_game : w->block_games;
+        Rng block = w->rng;
+        rng_long_jump(&w->rng);
+        for (int g = 0; g < n; ++g) {
+            int rounds = 0;
+            int seat = multi_play_game(w->board, &block, w->num_players, w->max_rounds, positions, &rounds);
+            w->res.games++;
+            if (seat < 0) {
+                w->res.timeouts++;
+                continue;
+            }
+            w->res.seat_wins[seat]++;
+            w->res.round_hist[rounds]++;
+        }
+    }
+    free(positions);
+    w->ok = true;
+    INSTR_ELAPSED(play_sec, t0);
+    instr_flush();
+    return NULL;
+}
+
+bool multi_run_batch(const Board *b, int num_games, int num_players, int max_rounds,
+                     const BatchOptions *opt, MultiResult *out) {
+    if (!b || !b->next_cell || num_games <= 0 || num_players <= 0 || max_rounds <= 0 ||
+        !opt || opt->num_threads <= 0 || !out) {
+        return false;
+    }
+    int block_games = simulator_block_games(num_games);
+    int num_blocks = (num_games - 1) / block_games + 1;
+    int num_threads = opt->num_threads < num_blocks ? opt->num_threads : num_blocks;
+
+    if (!multi_result_init(out, num_players, max_rounds)) return false;
+    MultiWorker *workers = calloc(num_threads, sizeof(MultiWorker));
+    pthread_t *threads = malloc(sizeof(pthread_t) * num_threads);
+    bool *started = calloc(num_threads, sizeof(bool));
+    bool ok = workers && threads && started;
+
+    // block k plays on the seed stream long-jumped k times, as in simulator_run_batch
+    Rng streams;
+    rng_seed(&streams, opt->seed);
+    int next_block = 0;
+    for (int t = 0; ok && t < num_threads; ++t) {
+        MultiWorker *w = &workers[t];
+        w->board = b;
+        w->first_block = next_block;
+        w->num_blocks = num_blocks / num_threads + (t < num_blocks % num_threads ? 1 : 0);
+        w->block_games = block_games;
+        w->num_games = num_games;
+        w->num_players = num_players;
+        w->max_rounds = max_rounds;
+        w->rng = streams;
+        for (int k = 0; k < w->num_blocks; ++k) {
+            rng_long_jump(&streams);
+        }
+        next_block += w->num_blocks;
+        ok = multi_result_init(&w->res, num_players, max_rounds);
+    }
+
+    // worker 0 runs on the calling thread, as does any worker whose thread fails to start
+    for (int t = 1; ok && t < num_threads; ++t) {
+        started[t] = pthread_create(&threads[t], NULL, multi_worker_run, &workers[t]) == 0;
+    }
+    if (ok) multi_worker_run(&workers[0]);
+    for (int t = 1; ok && t < num_threads; ++t) {
+        if (started[t]) pthread_join(threads[t], NULL);
+        else multi_worker_run(&workers[t]);
+    }
+
+    // merge in worker order so the result only depends on the options
+    INSTR_CLOCK(t0);
+    for (int t = 0; ok && t < num_threads; ++t) {
+        ok = workers[t].ok && multi_result_merge(out, &workers[t].res);
+    }
+    INSTR_ELAPSED(aggregate_sec, t0);
+
+    for (int t = 0; workers && t < num_threads; ++t) {
+        multi_result_free(&workers[t].res);
+    }
+    free(workers);
+    free(threads);
+    free(started);
+
+    if (!ok) multi_result_free(out);
+    return ok;
+}
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "result_io.h"
+
+typedef struct {
+    int64_t games;
+    int64_t wins;
+    int64_t timeouts;
+    int64_t sum_rolls;
+    int64_t best_rolls;
+    int64_t best_game;
+    int64_t best_len;
+} ResultCounters;
+
+size_t result_io_size(const BatchResult *res, int num_connections) {
+    return sizeof(ResultCounters) + sizeof(int32_t) * (size_t)res->best_len +
+           sizeof(int64_t) * ((size_t)num_connections + (size_t)res->max_steps + 1);
+}
+
+static char *result_io_append(char *p, const void *data, size_t len) {
+    memcpy(p, data, len);
+    return p + len;
+}
+
+char *result_io_put(char *p, const BatchResult *res, int num_connections) {
+    ResultCounters c = {res->games, res->wins, res->timeouts, res->sum_rolls,
+                        res->best_rolls, res->best_game, res->best_len};
+    p = result_io_append(p, &c, sizeof(c));
+    for (int i = 0; i < res->best_len; ++i) {
+        int32_t v = res->best_path[i];
+        p = result_io_append(p, &v, sizeof(v));
+    }
+    for (int i = 0; i < num_connections; ++i) {
+        int64_t v = res->conn_counts[i];
+        p = result_io_append(p, &v, sizeof(v));
+    }
+    for (int i = 0; i <= res->max_steps; ++i) {
+        int64_t v = res->hist[i];
+        p = result_io_append(p, &v, sizeof(v));
+    }
+    return p;
+}
+
+bool result_io_take(const char *buf, size_t size, size_t *pos, void *data, size_t len) {
+    if (*pos > size || len > size - *pos) return false;
+    memcpy(data, buf + *pos, len);
+    *pos += len;
+    return true;
+}
+
+bool result_io_get(const char *buf, size_t size, size_t *pos, int num_connections, int max_steps, BatchResult *out) {
+    if (!batch_result_init(out, num_connections, max_steps)) return false;
+    ResultCounters c;
+    bool ok = result_io_take(buf, size, pos, &c, sizeof(c)) &&
+              c.games >= 0 && c.games <= INT_MAX && c.wins >= 0 && c.timeouts >= 0 &&
+              c.best_len >= 0 && c.best_len <= max_steps;
+    if (ok) {
+        out->games = (int)c.games;
+        out->wins = (int)c.wins;
+        out->timeouts = (int)c.timeouts;
+        out->sum_rolls = (long)c.sum_rolls;
+        out->best_rolls = (int)c.best_rolls;
+        out->best_game = (int)c.best_game;
+        out->best_len = (int)c.best_len;
+        out->best_path = c.best_len > 0 ? malloc(sizeof(int) * (size_t)c.best_len) : NULL;
+        ok = c.best_len == 0 || out->best_path;
+    }
+    for (int i = 0; ok && i < out->best_len; ++i) {
+        int32_t v = 0;
+        ok = result_io_take(buf, size, pos, &v, sizeof(v));
+        out->best_path[i] = v;
+    }
+    for (int i = 0; ok && i < num_connections; ++i) {
+        int64_t v = 0;
+        ok = result_io_take(buf, size, pos, &v, sizeof(v));
+        out->conn_counts[i] = (long)v;
+    }
+    for (int i = 0; ok && i <= max_steps; ++i) {
+        int64_t v = 0;
+        ok = result_io_take(buf, size, pos, &v, sizeof(v));
+        out->hist[i] = (long)v;
+    }
+    if (!ok) batch_result_free(out);
+    return ok;
+}
+
+char *result_io_read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    char *buf = NULL;
+    bool ok = fseek(f, 0, SEEK_END) == 0;
+    long end = ok ? ftell(f) : -1;
+    ok = end >= 0 && fseek(f, 0, SEEK_SET) == 0;
+    if (ok) {
+        *size = (size_t)end;
+        buf = malloc(*size ? *size : 1);
+        ok = buf && fread(buf, 1, *size, f) == *size;
+    }
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "%s: read error\n", path);
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+bool result_io_write_file(const char *path, const char *buf, size_t size) {
+    size_t len = strlen(path);
+    char *tmp = malloc(len + 5);
+    if (!tmp) {
+        perror("malloc");
+        return false;
+    }
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+
+    FILE *f = fopen(tmp, "wb");
+    bool ok = f != NULL;
+    if (!f) perror(tmp);
+    if (ok) {
+        ok = fwrite(buf, 1, size, f) == size;
+        ok = fclose(f) == 0 && ok;
+    }
+    if (ok && rename(tmp, path) != 0) {
+        perror(path);
+        ok = false;
+    }
+    free(tmp);
+    return ok;
+}
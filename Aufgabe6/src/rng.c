@@ -0,0 +1,60 @@
+#include <stdint.h>
+#include "rng.h"
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void rng_seed(Rng *r, uint64_t seed) {
+    if (!r) return;
+    // splitmix64 never yields four zero words, so the state is always valid
+    for (int i = 0; i < 4; ++i) {
+        r->s[i] = splitmix64(&seed);
+    }
+}
+
+static void rng_apply_jump(Rng *r, const uint64_t jump[4]) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (int bit = 0; bit < 64; ++bit) {
+            if (jump[i] & (UINT64_C(1) << bit)) {
+                s0 ^= r->s[0];
+                s1 ^= r->s[1];
+                s2 ^= r->s[2];
+                s3 ^= r->s[3];
+            }
+            rng_next(r);
+        }
+    }
+    r->s[0] = s0;
+    r->s[1] = s1;
+    r->s[2] = s2;
+    r->s[3] = s3;
+}
+
+void rng_jump(Rng *r) {
+    static const uint64_t JUMP[4] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    if (!r) return;
+    rng_apply_jump(r, JUMP);
+}
+
+void rng_long_jump(Rng *r) {
+    static const uint64_t LONG_JUMP[4] = {
+        0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+        0x77710069854ee241ULL, 0x39109bb02acbe635ULL
+    };
+    if (!r) return;
+    rng_apply_jump(r, LONG_JUMP);
+}
+
+void rng_split(Rng *parent, Rng *child) {
+    if (!parent || !child) return;
+    *child = *parent;
+    rng_jump(parent);
+}
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shard.h"
+#include "checkpoint.h"
+#include "result_io.h"
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    int32_t shard_index;
+    int32_t shard_count;
+    int32_t num_games;
+    int32_t max_steps;
+    int32_t engine;
+    uint64_t seed;
+    int32_t rows;
+    int32_t cols;
+    int32_t die_sides;
+    int32_t exact_finish;
+    int32_t num_connections;
+    int32_t reserved;
+    uint64_t board_hash;   // checkpoint_board_hash
+} ShardHeader;
+
+bool shard_save(const char *path, const ShardInfo *info, const Board *b, const BatchResult *res) {
+    if (!path || !info || !b || !res) return false;
+    ShardHeader h = {
+        .version = SHARD_VERSION,
+        .shard_index = info->shard_index,
+        .shard_count = info->shard_count,
+        .num_games = info->num_games,
+        .max_steps = info->max_steps,
+        .engine = info->engine,
+        .seed = info->seed,
+        .rows = b->rows,
+        .cols = b->cols,
+        .die_sides = b->die_sides,
+        .exact_finish = b->exact_finish,
+        .num_connections = b->num_connections,
+        .board_hash = checkpoint_board_hash(b),
+    };
+    memcpy(h.magic, SHARD_MAGIC, sizeof(h.magic));
+
+    size_t size = sizeof(h) + sizeof(int32_t) * 2 * (size_t)b->num_connections +
+                  result_io_size(res, b->num_connections);
+    char *buf = malloc(size);
+    if (!buf) {
+        perror("malloc");
+        return false;
+    }
+    char *p = buf;
+    memcpy(p, &h, sizeof(h));
+    p += sizeof(h);
+    for (int i = 0; i < b->num_connections; ++i) {
+        int32_t pair[2] = {b->connections[i].start, b->connections[i].end};
+        memcpy(p, pair, sizeof(pair));
+        p += sizeof(pair);
+    }
+    result_io_put(p, res, b->num_connections);
+
+    bool ok = result_io_write_file(path, buf, size);
+    free(buf);
+    return ok;
+}
+
+// the board stored after h, checked against the hash of the header
+static Board *shard_read_board(const ShardHeader *h, const char *buf, size_t size, size_t *pos) {
+    if (h->rows < 1 || h->cols < 1 || (long long)h->rows * h->cols > BOARD_MAX_CELLS ||
+        h->die_sides < 1 || h->num_connections < 0) {
+        return NULL;
+    }
+    Board *b = create_board_reserved(h->rows, h->cols, h->die_sides, h->exact_finish != 0, h->num_connections);
+    bool ok = b != NULL;
+    for (int i = 0; ok && i < h->num_connections; ++i) {
+        int32_t pair[2];
+        ok = result_io_take(buf, size, pos, pair, sizeof(pair)) &&
+             board_add_connection(b, pair[0], pair[1]);
+    }
+    if (ok && checkpoint_board_hash(b) != h->board_hash) ok = false;
+    if (!ok) {
+        destroy_board(b);
+        return NULL;
+    }
+    return b;
+}
+
+static bool shard_same_run(const ShardHeader *a, const ShardHeader *b) {
+    return a->shard_count == b->shard_count && a->num_games == b->num_games &&
+           a->max_steps == b->max_steps && a->engine == b->engine && a->seed == b->seed &&
+           a->board_hash == b->board_hash;
+}
+
+bool shard_merge(const char *const *paths, int count, ShardInfo *info, Board **board, BatchResult *out) {
+    if (!paths || count < 1 || !info || !board || !out) return false;
+    *board = NULL;
+
+    ShardHeader first = {0};
+    bool *seen = NULL;
+    bool ok = true;
+    for (int f = 0; ok && f < count; ++f) {
+        size_t size = 0;
+        char *buf = result_io_read_file(paths[f], &size);
+        if (!buf) {
+            ok = false;
+            break;
+        }
+
+        size_t pos = 0;
+        ShardHeader h;
+        ok = result_io_take(buf, size, &pos, &h, sizeof(h)) &&
+             memcmp(h.magic, SHARD_MAGIC, sizeof(h.magic)) == 0 && h.version == SHARD_VERSION &&
+             h.shard_count >= 1 && h.shard_index >= 0 && h.shard_index < h.shard_count &&
+             h.max_steps >= 1;
+        if (!ok) {
+            fprintf(stderr, "%s: not a shard file\n", paths[f]);
+        } else if (f == 0) {
+            first = h;
+            seen = calloc((size_t)h.shard_count, sizeof(bool));
+            *board = seen ? shard_read_board(&h, buf, size, &pos) : NULL;
+            ok = *board && batch_result_init(out, h.num_connections, h.max_steps);
+            if (!ok) {
+                fprintf(stderr, "%s: damaged shard file\n", paths[f]);
+                destroy_board(*board);
+                *board = NULL;
+            }
+        } else if (!shard_same_run(&first, &h)) {
+            fprintf(stderr, "%s: shard of a different run than %s\n", paths[f], paths[0]);
+            ok = false;
+        } else {
+            pos += sizeof(int32_t) * 2 * (size_t)h.num_connections; // same board as the first file
+        }
+        if (ok && seen[h.shard_index]) {
+            fprintf(stderr, "%s: shard %d/%d given twice\n", paths[f], h.shard_index, h.shard_count);
+            ok = false;
+        }
+
+        BatchResult res;
+        if (ok) {
+            ok = result_io_get(buf, size, &pos, h.num_connections, h.max_steps, &res);
+            if (ok && pos != size) {
+                batch_result_free(&res);
+                ok = false;
+            }
+            if (!ok) fprintf(stderr, "%s: damaged shard file\n", paths[f]);
+        }
+        free(buf);
+        if (!ok) break;
+
+        // the fastest game has a global index, so the merge order does not matter
+        seen[h.shard_index] = true;
+        ok = batch_result_merge(out, &res, h.num_connections);
+        batch_result_free(&res);
+    }
+
+    if (ok) {
+        *info = (ShardInfo){
+            .shard_index = -1,
+            .shard_count = first.shard_count,
+            .num_games = first.num_games,
+            .max_steps = first.max_steps,
+            .engine = first.engine,
+            .seed = first.seed,
+        };
+    } else {
+        if (*board) batch_result_free(out);
+        destroy_board(*board);
+        *board = NULL;
+    }
+    free(seen);
+    return ok;
+}
@@ -3,37 +3,29 @@
 #include <limits.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
 #include "simulator.h"
 #include "utils.h"
+#include "lockstep.h"
+#include "instrument.h"
+#include "kernels.h"
+#include "checkpoint.h"
 
-int simulator_single_move(const Board *b, int position, int *roll_out, int *traversed_connection_index) {
-    if (!b || !traversed_connection_index || !roll_out) return position;
+int simulator_single_move(const Board *b, Rng *rng, int position, int *roll_out, int *traversed_connection_index) {
+    if (!b || !rng || !traversed_connection_index || !roll_out) return position;
 
     // roll the die and compute tentative new position
-    int roll = roll_die(b->die_sides);
+    int roll = roll_die(rng, b->die_sides);
     *roll_out = roll; // output the rolled value
 
-    //int new_pos = board_move(b, position, roll);
-    int new_pos;
-    if (position >= 0 && position < b->total_cells) {
-        new_pos = b->adj[position][roll - 1];
-    } else {
-        new_pos = board_move(b, position, roll);
-    }
-
-    // check for a snake or ladder at new_pos
-    for (int i = 0; i < b->num_connections; ++i) {
-        if (b->connections[i].start == new_pos) {
-            *traversed_connection_index = i;
-            return b->connections[i].end;
-        }
-    }
-
-    *traversed_connection_index = -1;
-    return new_pos;
+    // one lookup: the table already contains the snake/ladder jump
+    size_t idx = board_move_index(b, position, roll);
+    *traversed_connection_index = b->next_conn[idx];
+    return b->next_cell[idx];
 }
 
-bool simulator_play_single_game(const Board *b, int max_steps, int *total_rolls, int *path, int path_capacity, int *path_len, int *conn_path) {
+bool simulator_play_single_game(const Board *b, Rng *rng, int max_steps, int *total_rolls, int *path, int path_capacity, int *path_len, int *conn_path) {
     if (!b || !total_rolls || !path || !path_len || !conn_path) return false;
 
     int position = -1;          // start off the board
@@ -45,7 +37,7 @@ bool simulator_play_single_game(const Board *b, int max_steps, int *total_rolls,
 
         int connection_index = -1;
         // perform one move (does not return roll value here)
-        int next_pos = simulator_single_move(b, position, &roll_value, &connection_index);
+        int next_pos = simulator_single_move(b, rng, position, &roll_value, &connection_index);
         rolls++;
 
         // (hint: store roll values here if you extend the code)
@@ -66,78 +58,422 @@ bool simulator_play_single_game(const Board *b, int max_steps, int *total_rolls,
     return false;
 }
 
-bool simulator_run_batch(const Board *b, int num_games, int max_steps, double *avg_rolls, int *min_rolls, int **best_path, int *best_path_len, int *best_game_index, long **connection_counts) {
-    int best_game = -1; // to track the best game index
+bool batch_result_init(BatchResult *res, int num_connections, int max_steps) {
+    if (!res || max_steps < 0) return false;
+    res->games = 0;
+    res->wins = 0;
+    res->timeouts = 0;
+    res->sum_rolls = 0;
+    res->best_rolls = INT_MAX;
+    res->best_game = -1;
+    res->best_path = NULL;
+    res->best_len = 0;
+    res->max_steps = max_steps;
+    // Allocate array to count how often each connection is used
+    INSTR_ADD(allocs, 2);
+    res->conn_counts = calloc(num_connections > 0 ? num_connections : 1, sizeof(long));
+    res->hist = calloc((size_t)max_steps + 1, sizeof(long));
+    if (!res->conn_counts || !res->hist) {
+        batch_result_free(res);
+        return false;
+    }
+    return true;
+}
+
+void batch_result_free(BatchResult *res) {
+    if (!res) return;
+    free(res->best_path);
+    free(res->conn_counts);
+    free(res->hist);
+    res->best_path = NULL;
+    res->conn_counts = NULL;
+    res->hist = NULL;
+}
+
+// back to an empty result, keeping the counter arrays
+static void batch_result_reset(BatchResult *res, int num_connections) {
+    res->games = 0;
+    res->wins = 0;
+    res->timeouts = 0;
+    res->sum_rolls = 0;
+    res->best_rolls = INT_MAX;
+    res->best_game = -1;
+    res->best_len = 0;
+    free(res->best_path);
+    res->best_path = NULL;
+    memset(res->conn_counts, 0, sizeof(long) * (size_t)(num_connections > 0 ? num_connections : 1));
+    memset(res->hist, 0, sizeof(long) * ((size_t)res->max_steps + 1));
+}
+
+bool batch_result_merge(BatchResult *into, const BatchResult *from, int num_connections) {
+    if (!into || !from || into->max_steps != from->max_steps) return false;
+
+    into->games += from->games;
+    into->wins += from->wins;
+    into->timeouts += from->timeouts;
+    into->sum_rolls += from->sum_rolls;
+    for (int i = 0; i < num_connections; ++i) {
+        into->conn_counts[i] += from->conn_counts[i];
+    }
+    for (int r = 0; r <= into->max_steps; ++r) {
+        into->hist[r] += from->hist[r];
+    }
+
+    if (from->wins > 0 && (from->best_rolls < into->best_rolls ||
+        (from->best_rolls == into->best_rolls && from->best_game < into->best_game))) {
+        INSTR_ADD(allocs, 1);
+        int *p = malloc(sizeof(int) * (from->best_len > 0 ? from->best_len : 1));
+        if (!p) return false;
+        memcpy(p, from->best_path, sizeof(int) * from->best_len);
+        free(into->best_path);
+        into->best_path = p;
+        into->best_len = from->best_len;
+        into->best_rolls = from->best_rolls;
+        into->best_game = from->best_game;
+    }
+    return true;
+}
+
+// smallest r such that at least percent % of the wins took <= r rolls
+static int hist_percentile(const BatchResult *res, int percent) {
+    long cum = 0;
+    for (int r = 0; r <= res->max_steps; ++r) {
+        cum += res->hist[r];
+        if (cum * 100 >= (long)percent * res->wins) return r;
+    }
+    return res->max_steps;
+}
+
+void batch_result_summary(const BatchResult *res, BatchSummary *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!res || res->wins == 0) return;
+
+    long double sum = 0.0L;
+    long double sum_sq = 0.0L;
+    for (int r = 0; r <= res->max_steps; ++r) {
+        long double c = res->hist[r];
+        sum += c * r;
+        sum_sq += c * r * r;
+    }
+    long double n = res->wins;
+    long double mean = sum / n;
+
+    out->mean = (double)mean;
+    out->variance = res->wins > 1 ? (double)((sum_sq - sum * mean) / (n - 1)) : 0.0;
+    if (out->variance < 0.0) out->variance = 0.0; // rounding
+    out->ci95 = 1.96 * sqrt(out->variance / res->wins);
+    out->p50 = hist_percentile(res, 50);
+    out->p95 = hist_percentile(res, 95);
+    out->p99 = hist_percentile(res, 99);
+}
+
+int simulator_play_counted(const Board *b, Rng *rng, int max_steps, long *conn_counts, int *conn_hits) {
+    const int *next_cell = b->next_cell;
+    const int *next_conn = b->next_conn;
+    int sides = b->die_sides;
+    int last = b->total_cells - 1;
+    int position = -1;
+    int hits = 0;
+
+    for (int rolls = 1; rolls <= max_steps; ++rolls) {
+        size_t idx = board_move_index(b, position, roll_die(rng, sides));
+        int conn = next_conn[idx];
+        INSTR_ADD(bounces, next_cell[idx] == position && conn < 0);
+        position = next_cell[idx];
+        if (conn >= 0) {
+            conn_counts[conn]++;
+            hits++;
+            INSTR_ADD(conn_hits, 1);
+        }
+        if (position == last) {
+            *conn_hits = hits;
+            return rolls;
+        }
+    }
+    *conn_hits = hits;
+    return 0;
+}
+
+void simulator_uncount_game(const Board *b, const Rng *start, int max_steps, long *conn_counts) {
+    Rng r = *start;
+    int position = -1;
+    for (int i = 0; i < max_steps; ++i) {
+        int roll = 0, conn = -1;
+        position = simulator_single_move(b, &r, position, &roll, &conn);
+        if (conn >= 0) conn_counts[conn]--;
+    }
+}
 
-    if (!b || num_games <= 0 || !avg_rolls || !min_rolls || !best_path || !best_path_len || !connection_counts) {
+bool simulator_replay_best(const Board *b, const Rng *start, BatchResult *res) {
+    if (!b || !start || !res || res->best_rolls <= 0 || res->best_rolls == INT_MAX) return false;
+
+    INSTR_ADD(allocs, 2);
+    int *path = malloc(sizeof(int) * res->best_rolls);
+    int *conn_path = malloc(sizeof(int) * res->best_rolls);
+    if (!path || !conn_path) {
+        free(path);
+        free(conn_path);
         return false;
     }
+    Rng r = *start;
+    int rolls = 0;
+    int len = 0;
+    simulator_play_single_game(b, &r, res->best_rolls, &rolls, path, res->best_rolls, &len, conn_path);
+    free(conn_path);
+    free(res->best_path);
+    res->best_path = path;
+    res->best_len = len;
+    return true;
+}
 
-    int num_conn = b->num_connections;
+bool simulator_play_range(const Board *b, Rng *rng, int first_game, int num_games, int max_steps, BatchResult *res, TraceSink *trace) {
+    if (!b || !rng || !res || !res->conn_counts || res->max_steps != max_steps) return false;
 
-    // Allocate array to count how often each connection is used
-    long *conn_counts = calloc(num_conn, sizeof(long));
-    if (!conn_counts) return false;
-
-    int wins = 0;
-    long sum_rolls = 0;
-    int best_rolls = INT_MAX;
-    int *best_p = NULL;
-    int best_len = 0;
-
-    // Temporary buffer to store the roll sequence of each game
-    int *path_buffer = malloc(sizeof(int) * max_steps);
-    int *conn_buffer = malloc(sizeof(int) * max_steps);
-    if (!path_buffer || !conn_buffer) {
-        free(conn_counts);
-        free(path_buffer);
-        free(conn_buffer);
+    // only the random state at the start of each game is kept, nothing is recorded per roll
+    SimKernel play = sim_kernel_pick(b, NULL);
+    bool improved = false;
+    Rng best_start = *rng;
+    for (int g = first_game; g < first_game + num_games; ++g) {
+        Rng start = *rng;
+        int hits = 0;
+        int rolls = play(b, rng, max_steps, res->conn_counts, &hits);
+        INSTR_ADD(moves, rolls ? rolls : max_steps);
+        if (trace) trace_record(trace, g, rolls, hits, &start);
+
+        res->games++;
+        if (rolls == 0) {
+            res->timeouts++;
+            INSTR_ADD(timeouts, 1);
+            simulator_uncount_game(b, &start, max_steps, res->conn_counts);
+            continue;
+        }
+        res->wins++;
+        res->sum_rolls += rolls;
+        res->hist[rolls]++;
+
+        // remember where the shortest winning game started
+        if (rolls < res->best_rolls) {
+            res->best_rolls = rolls;
+            res->best_game = g; // update the best game index
+            best_start = start;
+            improved = true;
+        }
+    }
+
+    // re-simulate the fastest game once to recover its rolls
+    return !improved || simulator_replay_best(b, &best_start, res);
+}
+
+int simulator_block_games(int num_games) {
+    int games = num_games / SIM_MIN_BLOCKS;
+    if (games < 1) return 1;
+    return games < SIM_BLOCK_GAMES ? games : SIM_BLOCK_GAMES;
+}
+
+/* Work and results of one batch worker.
+ * Every worker plays the blocks [first_block, first_block + num_blocks)
+ * with its own buffers and connection counters; rng is the stream of its
+ * next block.
+ */
+typedef struct {
+    const Board *board;
+    int first_block;
+    int num_blocks;
+    int block_games;
+    int num_games;     // of the whole run, only its last block is shorter
+    int max_steps;
+    SimEngine engine;
+    Rng rng;
+    TraceSink *trace;  // NULL without --trace
+
+    bool ok;           // false if the worker ran out of memory
+    BatchResult res;
+} BatchWorker;
+
+static void *batch_worker_run(void *arg) {
+    BatchWorker *w = arg;
+    INSTR_CLOCK(t0);
+    w->ok = true;
+    for (int k = w->first_block; w->ok && k < w->first_block + w->num_blocks; ++k) {
+        int first_game = k * w->block_games;
+        int n = w->num_games - first_game < w->block_games ? w->num_games - first_game : w->block_games;
+        Rng block = w->rng;
+        rng_long_jump(&w->rng);
+        if (w->engine == SIM_ENGINE_LOCKSTEP) {
+            w->ok = lockstep_play_range(w->board, &block, first_game, n, w->max_steps, &w->res, w->trace);
+        } else {
+            w->ok = simulator_play_range(w->board, &block, first_game, n, w->max_steps, &w->res, w->trace);
+        }
+    }
+    INSTR_ELAPSED(play_sec, t0);
+    instr_flush();
+    return NULL;
+}
+
+/* Plays blocks [first_block, first_block + num_blocks) split into contiguous
+ * shares, the first workers get the remainder; streams is the stream of
+ * first_block and ends up at the one of the next block. Worker 0 runs on
+ * the calling thread, as does any worker whose thread can not be started.
+ */
+static bool batch_run_round(BatchWorker *workers, pthread_t *threads, int num_threads, Rng *streams, int first_block, int num_blocks) {
+    int share = num_blocks / num_threads;
+    int rest = num_blocks % num_threads;
+    int next_block = first_block;
+    for (int t = 0; t < num_threads; ++t) {
+        workers[t].first_block = next_block;
+        workers[t].num_blocks = share + (t < rest ? 1 : 0);
+        workers[t].rng = *streams;
+        for (int k = 0; k < workers[t].num_blocks; ++k) {
+            rng_long_jump(streams);
+        }
+        next_block += workers[t].num_blocks;
+    }
+    int active = num_blocks < num_threads ? num_blocks : num_threads;
+
+    bool *started = calloc(num_threads, sizeof(bool));
+    if (!started) return false;
+    for (int t = 1; t < active; ++t) {
+        started[t] = pthread_create(&threads[t], NULL, batch_worker_run, &workers[t]) == 0;
+    }
+    batch_worker_run(&workers[0]);
+
+    bool ok = workers[0].ok;
+    for (int t = 1; t < active; ++t) {
+        if (started[t]) pthread_join(threads[t], NULL);
+        else batch_worker_run(&workers[t]);
+        ok = ok && workers[t].ok;
+    }
+    free(started);
+    return ok;
+}
+
+bool simulator_run_batch(const Board *b, int num_games, int max_steps, const BatchOptions *opt, BatchResult *out) {
+    if (!b || num_games <= 0 || max_steps <= 0 || !opt || opt->num_threads <= 0 || !out) {
         return false;
     }
+    int shard_count = opt->shard_count > 0 ? opt->shard_count : 1;
+    if (opt->shard_index < 0 || opt->shard_index >= shard_count) return false;
+    int block_games = simulator_block_games(num_games);
+    int num_blocks = (num_games - 1) / block_games + 1;
+    int first_block = (int)((long long)num_blocks * opt->shard_index / shard_count);
+    int shard_blocks = (int)((long long)num_blocks * (opt->shard_index + 1) / shard_count) - first_block;
+    if (shard_blocks <= 0) return false;
+    int num_threads = opt->num_threads < shard_blocks ? opt->num_threads : shard_blocks;
+    int num_conn = b->num_connections;
 
-    for (int g = 0; g < num_games; ++g) {
-        int rolls = 0;
-        int path_len = 0;
-        bool won = simulator_play_single_game(b, max_steps, &rolls, path_buffer, max_steps, &path_len, conn_buffer);
+    if (!batch_result_init(out, num_conn, max_steps)) return false;
+    BatchWorker *workers = calloc(num_threads, sizeof(BatchWorker));
+    pthread_t *threads = malloc(sizeof(pthread_t) * num_threads);
+    bool ok = workers && threads;
 
-        if (!won) continue;
-        wins++;
-        sum_rolls += rolls;
+    for (int t = 0; ok && t < num_threads; ++t) {
+        BatchWorker *w = &workers[t];
+        w->board = b;
+        w->block_games = block_games;
+        w->num_games = num_games;
+        w->max_steps = max_steps;
+        w->engine = opt->engine;
+        w->trace = opt->trace ? trace_sink(opt->trace, t) : NULL;
+        ok = batch_result_init(&w->res, num_conn, max_steps);
+    }
 
-        for (int i = 0; i < path_len; ++i) {
-            int conn_index = conn_buffer[i];
-            if (conn_index >= 0 && conn_index < num_conn) {
-                conn_counts[conn_index]++;
+    // one round of all blocks, or rounds doubling the sample until the CI is tight enough
+    int round = shard_blocks;
+    if (opt->target_ci > 0) {
+        round = (10000 - 1) / block_games + 1;
+    } else if (opt->checkpoint_every > 0) {
+        round = (opt->checkpoint_every - 1) / block_games + 1;
+    }
+
+    int played = 0; // blocks of the shard merged into out
+    bool done = false;
+    CheckpointWriter *ckpt = NULL;
+    CheckpointState state = {
+        .key = {
+            .seed = opt->seed,
+            .board_hash = checkpoint_board_hash(b),
+            .num_games = num_games,
+            .max_steps = max_steps,
+            .block_games = block_games,
+            .engine = opt->engine,
+            .checkpoint_every = opt->checkpoint_every,
+            .shard_index = opt->shard_index,
+            .shard_count = shard_count,
+            .target_ci = opt->target_ci,
+        },
+    };
+    if (ok && opt->checkpoint_path) {
+        if (opt->resume) {
+            CheckpointState saved;
+            ok = checkpoint_load(opt->checkpoint_path, &state.key, num_conn, &saved);
+            if (ok) {
+                batch_result_free(out);
+                *out = saved.result;
+                saved.result = (BatchResult){0};
+                played = saved.played;
+                round = saved.round;
+                checkpoint_state_free(&saved);
+
+                // the original run stops at this point if the CI was already reached
+                BatchSummary summary;
+                batch_result_summary(out, &summary);
+                done = opt->target_ci > 0 && out->wins > 1 && summary.ci95 <= opt->target_ci;
             }
         }
+        ckpt = ok ? checkpoint_writer_create(opt->checkpoint_path) : NULL;
+        ok = ok && ckpt;
+    }
 
-        // Save the shortest winning sequence
-        if (rolls < best_rolls) {
-            best_rolls = rolls;
-            best_len = path_len;
-            best_game = g; // update the best game index
-            free(best_p);
-            best_p = malloc(sizeof(int) * path_len);
-            if (best_p) {
-                memcpy(best_p, path_buffer, sizeof(int) * path_len);
-            }
+    // block k plays on the seed stream long-jumped k times
+    Rng streams;
+    rng_seed(&streams, opt->seed);
+    for (int k = 0; ok && k < first_block + played; ++k) {
+        rng_long_jump(&streams);
+    }
+
+    while (ok && !done && played < shard_blocks) {
+        int n = round < shard_blocks - played ? round : shard_blocks - played;
+        ok = batch_run_round(workers, threads, num_threads, &streams, first_block + played, n);
+        played += n;
+
+        // merge in worker order so the result only depends on the options
+        INSTR_CLOCK(t0);
+        for (int t = 0; ok && t < num_threads; ++t) {
+            ok = batch_result_merge(out, &workers[t].res, num_conn);
+            batch_result_reset(&workers[t].res, num_conn);
+        }
+        INSTR_ELAPSED(aggregate_sec, t0);
+
+        if (ok && opt->target_ci > 0) {
+            BatchSummary summary;
+            batch_result_summary(out, &summary);
+            done = out->wins > 1 && summary.ci95 <= opt->target_ci;
+            if (!done) round = played;
+        }
+
+        // the writer copies the state, the next round starts right away
+        if (ok && ckpt) {
+            state.played = played;
+            state.round = round;
+            state.result = *out;
+            ok = checkpoint_writer_submit(ckpt, &state, num_conn);
         }
     }
+    if (ckpt && !checkpoint_writer_finish(ckpt)) {
+        fprintf(stderr, "simulator_run_batch: writing checkpoint %s failed\n", opt->checkpoint_path);
+        ok = false;
+    }
 
-    free(path_buffer);
-    free(conn_buffer);
+    for (int t = 0; workers && t < num_threads; ++t) {
+        batch_result_free(&workers[t].res);
+    }
+    free(workers);
+    free(threads);
 
-    if (wins == 0) {
-        free(conn_counts);
+    if (!ok || out->wins == 0) {
+        batch_result_free(out);
         return false;
     }
-
-    // Compute average rolls and set output parameters
-    *avg_rolls = (double)sum_rolls / wins;
-    *min_rolls = best_rolls;
-    *best_path = best_p;
-    *best_path_len = best_len;
-    *best_game_index = best_game; 
-    *connection_counts = conn_counts;
     return true;
-}
\ No newline at end of file
+}
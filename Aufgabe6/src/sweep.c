@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "sweep.h"
+#include "board.h"
+#include "lockstep.h"
+#include "instrument.h"
+
+/* a slice of the games of one configuration */
+typedef struct {
+    int config;
+    int first_game;
+    int num_games;
+    Rng rng;
+    bool ok;
+    BatchResult res;
+} SweepJob;
+
+/* Board of one configuration: built by its first job, freed after its last
+ * one, so only the configurations in play hold a board
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    bool built;         // a job tried to build board
+    bool fits;          // false if the connections turned out not to fit
+    Board *board;
+    int jobs_left;
+} SweepConfig;
+
+typedef struct {
+    const SweepSpec *spec;
+    const SweepRow *rows;
+    SweepConfig *configs;
+    SweepJob *jobs;
+    int num_jobs;
+    atomic_int next_job;
+} SweepPool;
+
+static int range_count(const SweepRange *r) {
+    if (r->step < 1 || r->last < r->first) return 0;
+    return (r->last - r->first) / r->step + 1;
+}
+
+// whether the board and the connection set of a configuration fit, without building it
+static bool sweep_fits(const SweepSpec *spec, const SweepRow *row) {
+    if ((long long)row->rows * row->cols > BOARD_MAX_CELLS) return false;
+    int last = row->rows * row->cols - 1;
+    for (int i = 0; i < spec->num_pairs; ++i) {
+        int start = spec->pairs[i][0];
+        int end = spec->pairs[i][1];
+        // check the range here, board_add_connection would complain on stderr
+        if (start < 0 || start >= last || end < 0 || end > last) return false;
+    }
+    return true;
+}
+
+/* board of one configuration with the shared connection set; NULL with
+ * *fits false if the connections do not fit, NULL with *fits true (and a
+ * message) if it can not be allocated
+ */
+static Board *sweep_board(const SweepSpec *spec, const SweepRow *row, bool *fits) {
+    *fits = sweep_fits(spec, row);
+    if (!*fits) return NULL;
+    Board *b = create_board_reserved(row->rows, row->cols, row->die_sides, row->exact_finish, spec->num_pairs);
+    if (!b) {
+        fprintf(stderr, "sweep: out of memory for the %dx%d board with %d sides\n", row->rows, row->cols, row->die_sides);
+        return NULL;
+    }
+    for (int i = 0; i < spec->num_pairs; ++i) {
+        if (!board_add_connection(b, spec->pairs[i][0], spec->pairs[i][1])) {
+            destroy_board(b);
+            *fits = false;
+            return NULL;
+        }
+    }
+    board_build_graph(b);
+    return b;
+}
+
+static void *sweep_worker(void *arg) {
+    SweepPool *pool = arg;
+    const SweepSpec *spec = pool->spec;
+    for (;;) {
+        int j = atomic_fetch_add(&pool->next_job, 1);
+        if (j >= pool->num_jobs) break;
+
+        SweepJob *job = &pool->jobs[j];
+        SweepConfig *config = &pool->configs[job->config];
+        pthread_mutex_lock(&config->lock);
+        if (!config->built) {
+            config->board = sweep_board(spec, &pool->rows[job->config], &config->fits);
+            config->built = true;
+        }
+        const Board *b = config->board;
+        pthread_mutex_unlock(&config->lock);
+
+        // without a board the job fails if it could not be allocated, else the configuration is left out
+        INSTR_CLOCK(t0);
+        job->ok = b ? batch_result_init(&job->res, b->num_connections, spec->max_steps) : !config->fits;
+        if (b && job->ok) {
+            if (spec->engine == SIM_ENGINE_LOCKSTEP) {
+                job->ok = lockstep_play_range(b, &job->rng, job->first_game, job->num_games, spec->max_steps, &job->res, NULL);
+            } else {
+                job->ok = simulator_play_range(b, &job->rng, job->first_game, job->num_games, spec->max_steps, &job->res, NULL);
+            }
+        }
+        INSTR_ELAPSED(play_sec, t0);
+
+        pthread_mutex_lock(&config->lock);
+        if (--config->jobs_left == 0) {
+            destroy_board(config->board);
+            config->board = NULL;
+        }
+        pthread_mutex_unlock(&config->lock);
+    }
+    instr_flush();
+    return NULL;
+}
+
+bool sweep_run(const SweepSpec *spec, SweepRow **rows_out, int *count) {
+    if (!spec || !rows_out || !count || spec->num_games <= 0 || spec->max_steps <= 0 ||
+        spec->num_threads <= 0 || (spec->num_pairs > 0 && !spec->pairs)) {
+        return false;
+    }
+    int n_rows = range_count(&spec->rows);
+    int n_cols = range_count(&spec->cols);
+    int n_dice = range_count(&spec->die_sides);
+    int n_exact = range_count(&spec->exact_finish);
+    long long total = (long long)n_rows * n_cols * n_dice * n_exact;
+    if (total <= 0 || total > INT_MAX) return false;
+    int num_configs = (int)total;
+
+    SweepRow *rows = calloc(num_configs, sizeof(SweepRow));
+    SweepConfig *configs = calloc(num_configs, sizeof(SweepConfig));
+    if (!rows || !configs) {
+        perror("calloc");
+        free(rows);
+        free(configs);
+        return false;
+    }
+
+    // configurations in table order; the boards are only built while their jobs run
+    int c = 0;
+    int chunks_per_config = (spec->num_games - 1) / SWEEP_CHUNK_GAMES + 1;
+    for (int ri = 0; ri < n_rows; ++ri)
+    for (int ci = 0; ci < n_cols; ++ci)
+    for (int di = 0; di < n_dice; ++di)
+    for (int ei = 0; ei < n_exact; ++ei, ++c) {
+        SweepRow *row = &rows[c];
+        row->rows = spec->rows.first + ri * spec->rows.step;
+        row->cols = spec->cols.first + ci * spec->cols.step;
+        row->die_sides = spec->die_sides.first + di * spec->die_sides.step;
+        row->exact_finish = spec->exact_finish.first + ei * spec->exact_finish.step != 0;
+        row->valid = sweep_fits(spec, row);
+        pthread_mutex_init(&configs[c].lock, NULL);
+        configs[c].fits = true;
+        configs[c].jobs_left = row->valid ? chunks_per_config : 0;
+    }
+
+    int num_valid = 0;
+    for (c = 0; c < num_configs; ++c) {
+        num_valid += rows[c].valid;
+    }
+    SweepPool pool = {
+        .spec = spec,
+        .rows = rows,
+        .configs = configs,
+        .jobs = calloc((size_t)num_valid * chunks_per_config + 1, sizeof(SweepJob)),
+        .num_jobs = num_valid * chunks_per_config,
+    };
+    atomic_init(&pool.next_job, 0);
+    bool ok = pool.jobs != NULL;
+
+    // job j plays on the seed stream long-jumped j times
+    Rng streams;
+    rng_seed(&streams, spec->seed);
+    int j = 0;
+    for (c = 0; ok && c < num_configs; ++c) {
+        if (!rows[c].valid) continue;
+        for (int k = 0; k < chunks_per_config; ++k, ++j) {
+            SweepJob *job = &pool.jobs[j];
+            job->config = c;
+            job->first_game = k * SWEEP_CHUNK_GAMES;
+            job->num_games = spec->num_games - job->first_game < SWEEP_CHUNK_GAMES
+                           ? spec->num_games - job->first_game : SWEEP_CHUNK_GAMES;
+            job->rng = streams;
+            rng_long_jump(&streams);
+        }
+    }
+
+    // one pool for all jobs, the calling thread works too
+    int num_threads = spec->num_threads < pool.num_jobs ? spec->num_threads : pool.num_jobs;
+    pthread_t *threads = malloc(sizeof(pthread_t) * (num_threads > 0 ? num_threads : 1));
+    bool *started = calloc(num_threads > 0 ? num_threads : 1, sizeof(bool));
+    if (ok && threads && started) {
+        for (int t = 1; t < num_threads; ++t) {
+            started[t] = pthread_create(&threads[t], NULL, sweep_worker, &pool) == 0;
+        }
+        sweep_worker(&pool);
+        for (int t = 1; t < num_threads; ++t) {
+            if (started[t]) pthread_join(threads[t], NULL);
+        }
+    } else {
+        ok = false;
+    }
+    free(threads);
+    free(started);
+
+    // merge the jobs of each configuration in order
+    INSTR_CLOCK(t0);
+    j = 0;
+    for (c = 0; ok && c < num_configs; ++c) {
+        if (!rows[c].valid) continue;
+        // board_add_connection refused the connection set, nothing was played
+        if (!configs[c].fits) {
+            rows[c].valid = false;
+            j += chunks_per_config;
+            continue;
+        }
+        ok = batch_result_init(&rows[c].result, spec->num_pairs, spec->max_steps);
+        for (int k = 0; k < chunks_per_config; ++k, ++j) {
+            ok = ok && pool.jobs[j].ok &&
+                 batch_result_merge(&rows[c].result, &pool.jobs[j].res, spec->num_pairs);
+        }
+    }
+
+    INSTR_ELAPSED(aggregate_sec, t0);
+
+    for (j = 0; pool.jobs && j < pool.num_jobs; ++j) {
+        batch_result_free(&pool.jobs[j].res);
+    }
+    free(pool.jobs);
+    for (c = 0; c < num_configs; ++c) {
+        destroy_board(configs[c].board); // left over if a job never ran
+        pthread_mutex_destroy(&configs[c].lock);
+    }
+    free(configs);
+
+    if (!ok) {
+        sweep_free(rows, num_configs);
+        return false;
+    }
+    *rows_out = rows;
+    *count = num_configs;
+    return true;
+}
+
+void sweep_free(SweepRow *rows, int count) {
+    if (!rows) return;
+    for (int i = 0; i < count; ++i) {
+        if (rows[i].valid) batch_result_free(&rows[i].result);
+    }
+    free(rows);
+}
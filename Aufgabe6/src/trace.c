@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "trace.h"
+
+// a buffer waiting for the writer
+typedef struct {
+    TraceSink *sink;
+    int which;
+    int count;
+} TraceJob;
+
+struct TraceWriter {
+    FILE *file;
+    TraceFormat format;
+    bool threaded;        // false: buffers are written by the submitting thread
+    bool closing;
+    bool failed;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;  // queue changed or a buffer became free
+    TraceJob *queue;      // ring, at most one job per producer
+    int head;
+    int len;
+    int num_producers;
+    TraceSink *sinks;
+    char *text;           // CSV formatting buffer of the writer
+};
+
+// longest CSV line: four 10-digit and four 20-digit numbers, a flag, separators and newline
+#define TRACE_CSV_LINE 160
+
+// decimal digits of v followed by sep, returns the position after them
+static char *trace_put_uint(char *p, uint64_t v, char sep) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n > 0) *p++ = digits[--n];
+    *p++ = sep;
+    return p;
+}
+
+static bool trace_write(TraceWriter *w, const TraceRecord *r, int count) {
+    if (w->format == TRACE_BINARY) {
+        return fwrite(r, sizeof(TraceRecord), (size_t)count, w->file) == (size_t)count;
+    }
+    // printf would dominate the writer, the lines are formatted by hand
+    char *p = w->text;
+    for (int i = 0; i < count; ++i) {
+        p = trace_put_uint(p, r[i].board, ',');
+        p = trace_put_uint(p, r[i].game, ',');
+        *p++ = r[i].rolls != 0 ? '1' : '0';
+        *p++ = ',';
+        p = trace_put_uint(p, r[i].rolls, ',');
+        p = trace_put_uint(p, r[i].conn_hits, ',');
+        for (int k = 0; k < 4; ++k) {
+            p = trace_put_uint(p, r[i].start[k], k < 3 ? ',' : '\n');
+        }
+    }
+    size_t len = (size_t)(p - w->text);
+    return fwrite(w->text, 1, len, w->file) == len;
+}
+
+static void *trace_writer_run(void *arg) {
+    TraceWriter *w = arg;
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (w->len == 0 && !w->closing) {
+            pthread_cond_wait(&w->cond, &w->lock);
+        }
+        if (w->len == 0) break;
+        TraceJob job = w->queue[w->head];
+        w->head = (w->head + 1) % w->num_producers;
+        w->len--;
+        pthread_mutex_unlock(&w->lock);
+
+        bool ok = trace_write(w, job.sink->buf[job.which], job.count);
+
+        pthread_mutex_lock(&w->lock);
+        if (!ok) w->failed = true;
+        job.sink->busy[job.which] = false;
+        pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+void trace_submit(TraceSink *s) {
+    TraceWriter *w = s->writer;
+    if (s->fill == 0) return;
+    if (!w->threaded) {
+        // the workers write themselves, one at a time (they share file and text)
+        pthread_mutex_lock(&w->lock);
+        if (!trace_write(w, s->buf[s->cur], s->fill)) w->failed = true;
+        pthread_mutex_unlock(&w->lock);
+        s->fill = 0;
+        return;
+    }
+
+    int other = s->cur ^ 1;
+    pthread_mutex_lock(&w->lock);
+    while (s->busy[other]) {
+        pthread_cond_wait(&w->cond, &w->lock); // the writer is a whole buffer behind
+    }
+    s->busy[s->cur] = true;
+    w->queue[(w->head + w->len) % w->num_producers] = (TraceJob){s, s->cur, s->fill};
+    w->len++;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+
+    s->cur = other;
+    s->fill = 0;
+}
+
+TraceWriter *trace_open(const char *path, TraceFormat format, int num_producers, int max_steps, uint64_t seed) {
+    if (!path || num_producers < 1 || max_steps < 0) return NULL;
+    TraceWriter *w = calloc(1, sizeof(TraceWriter));
+    if (!w) {
+        perror("calloc");
+        return NULL;
+    }
+    w->format = format;
+    w->num_producers = num_producers;
+    w->queue = malloc(sizeof(TraceJob) * num_producers);
+    w->sinks = calloc(num_producers, sizeof(TraceSink));
+    if (format == TRACE_CSV) {
+        w->text = malloc((size_t)TRACE_BUFFER_RECORDS * TRACE_CSV_LINE);
+    }
+    bool ok = w->queue && w->sinks && (format != TRACE_CSV || w->text);
+    for (int i = 0; ok && i < num_producers; ++i) {
+        w->sinks[i].writer = w;
+        w->sinks[i].buf[0] = malloc(sizeof(TraceRecord) * TRACE_BUFFER_RECORDS * 2);
+        w->sinks[i].buf[1] = w->sinks[i].buf[0] ? w->sinks[i].buf[0] + TRACE_BUFFER_RECORDS : NULL;
+        ok = w->sinks[i].buf[0] != NULL;
+    }
+    if (!ok) perror("malloc");
+
+    w->file = ok ? fopen(path, format == TRACE_CSV ? "w" : "wb") : NULL;
+    if (ok && !w->file) {
+        perror(path);
+        ok = false;
+    }
+    if (ok && format == TRACE_BINARY) {
+        TraceFileHeader h = {.version = TRACE_VERSION, .record_size = sizeof(TraceRecord),
+                             .max_steps = (uint32_t)max_steps, .seed = seed};
+        memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+        ok = fwrite(&h, sizeof(h), 1, w->file) == 1;
+    } else if (ok) {
+        ok = fputs("board,game,won,rolls,conn_hits,rng0,rng1,rng2,rng3\n", w->file) >= 0;
+    }
+    if (!ok) {
+        if (w->file) fclose(w->file);
+        for (int i = 0; w->sinks && i < num_producers; ++i) {
+            free(w->sinks[i].buf[0]);
+        }
+        free(w->sinks);
+        free(w->queue);
+        free(w->text);
+        free(w);
+        return NULL;
+    }
+
+    // large stdio buffer, the writer hands over whole blocks anyway
+    setvbuf(w->file, NULL, _IOFBF, 1 << 20);
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->cond, NULL);
+    w->threaded = pthread_create(&w->thread, NULL, trace_writer_run, w) == 0;
+    return w;
+}
+
+TraceSink *trace_sink(TraceWriter *w, int i) {
+    if (!w || i < 0 || i >= w->num_producers) return NULL;
+    return &w->sinks[i];
+}
+
+void trace_set_board(TraceWriter *w, int board) {
+    for (int i = 0; w && i < w->num_producers; ++i) {
+        w->sinks[i].board = (uint32_t)board;
+    }
+}
+
+bool trace_close(TraceWriter *w) {
+    if (!w) return false;
+    for (int i = 0; i < w->num_producers; ++i) {
+        trace_submit(&w->sinks[i]);
+    }
+    if (w->threaded) {
+        pthread_mutex_lock(&w->lock);
+        w->closing = true;
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+        pthread_join(w->thread, NULL);
+    }
+    bool ok = !w->failed;
+    if (fclose(w->file) != 0) ok = false;
+
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->cond);
+    for (int i = 0; i < w->num_producers; ++i) {
+        free(w->sinks[i].buf[0]);
+    }
+    free(w->sinks);
+    free(w->queue);
+    free(w->text);
+    free(w);
+    return ok;
+}
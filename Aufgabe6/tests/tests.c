@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "board.h"
+#include "simulator.h"
+#include "trace.h"
+#include "multiplayer.h"
+
+/* Regression tests for properties the batch runs promise: run with
+ * `make test`, prints one line per test and exits with 1 if any failed.
+ */
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+static void run_test(const char *name, bool (*test)(void)) {
+    bool ok = test();
+    printf("%-40s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok) failures++;
+}
+
+// 10x10 board with a few snakes and ladders, transition table built
+static Board *test_board(void) {
+    static const int pairs[][2] = {{3, 40}, {12, 60}, {50, 7}, {88, 24}, {71, 93}};
+    Board *b = create_board(10, 10, 6, true);
+    if (!b) return NULL;
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); ++i) {
+        board_add_connection(b, pairs[i][0], pairs[i][1]);
+    }
+    board_build_graph(b);
+    return b;
+}
+
+static bool same_result(const BatchResult *a, const BatchResult *b, int num_connections) {
+    CHECK(a->games == b->games && a->wins == b->wins && a->timeouts == b->timeouts);
+    CHECK(a->sum_rolls == b->sum_rolls);
+    CHECK(a->best_rolls == b->best_rolls && a->best_game == b->best_game && a->best_len == b->best_len);
+    CHECK(memcmp(a->best_path, b->best_path, sizeof(int) * a->best_len) == 0);
+    CHECK(memcmp(a->conn_counts, b->conn_counts, sizeof(long) * num_connections) == 0);
+    CHECK(memcmp(a->hist, b->hist, sizeof(long) * ((size_t)a->max_steps + 1)) == 0);
+    return true;
+}
+
+/* The shards of a run, each played with its own thread count, merge into
+ * the result of the unsharded run
+ */
+static bool shards_merge_to_plain_run(SimEngine engine) {
+    enum { GAMES = 100000, STEPS = 200, SHARDS = 3 };
+    static const int shard_threads[SHARDS] = {1, 4, 7};
+    Board *b = test_board();
+    CHECK(b);
+    int num_conn = b->num_connections;
+
+    BatchOptions opt = {.num_threads = 2, .seed = 42, .engine = engine};
+    BatchResult plain, merged, shard;
+    CHECK(simulator_run_batch(b, GAMES, STEPS, &opt, &plain));
+    CHECK(batch_result_init(&merged, num_conn, STEPS));
+    bool ok = true;
+    for (int i = 0; ok && i < SHARDS; ++i) {
+        BatchOptions shard_opt = opt;
+        shard_opt.num_threads = shard_threads[i];
+        shard_opt.shard_index = i;
+        shard_opt.shard_count = SHARDS;
+        ok = simulator_run_batch(b, GAMES, STEPS, &shard_opt, &shard) &&
+             batch_result_merge(&merged, &shard, num_conn);
+        batch_result_free(&shard);
+    }
+    ok = ok && same_result(&plain, &merged, num_conn);
+    batch_result_free(&plain);
+    batch_result_free(&merged);
+    destroy_board(b);
+    return ok;
+}
+
+static bool test_shards_scalar(void) {
+    return shards_merge_to_plain_run(SIM_ENGINE_SCALAR);
+}
+
+static bool test_shards_lockstep(void) {
+    return shards_merge_to_plain_run(SIM_ENGINE_LOCKSTEP);
+}
+
+// k-player batches give the same result with any number of threads
+static bool test_multiplayer_threads(void) {
+    enum { GAMES = 20000, PLAYERS = 3, ROUNDS = 100 };
+    Board *b = test_board();
+    CHECK(b);
+    MultiResult one, many;
+    BatchOptions opt = {.num_threads = 1, .seed = 5};
+    bool ok = multi_run_batch(b, GAMES, PLAYERS, ROUNDS, &opt, &one);
+    opt.num_threads = 5;
+    ok = multi_run_batch(b, GAMES, PLAYERS, ROUNDS, &opt, &many) && ok;
+    destroy_board(b);
+    CHECK(ok);
+    ok = one.games == many.games && one.timeouts == many.timeouts &&
+         memcmp(one.seat_wins, many.seat_wins, sizeof(long) * PLAYERS) == 0 &&
+         memcmp(one.round_hist, many.round_hist, sizeof(long) * (ROUNDS + 1)) == 0;
+    multi_result_free(&one);
+    multi_result_free(&many);
+    return ok;
+}
+
+// plays the traced game again from its start state, true if it ends the same way
+static bool replays(const Board *b, const TraceRecord *r, int max_steps, long *conn_counts) {
+    Rng rng = {{r->start[0], r->start[1], r->start[2], r->start[3]}};
+    int hits = 0;
+    int rolls = simulator_play_counted(b, &rng, max_steps, conn_counts, &hits);
+    return (uint32_t)rolls == r->rolls && (uint32_t)hits == r->conn_hits;
+}
+
+/* Traces a run into a temporary file and replays every game of it; returns
+ * the number of games replayed, -1 on a failed check
+ */
+static int trace_and_replay(TraceFormat format, SimEngine engine) {
+    enum { GAMES = 5000, STEPS = 60, THREADS = 3 };
+    char path[] = "/tmp/snakes_tests_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return -1;
+    close(fd);
+
+    Board *b = test_board();
+    long *counts = b ? calloc(b->num_connections, sizeof(long)) : NULL;
+    BatchOptions opt = {.num_threads = THREADS, .seed = 7, .engine = engine};
+    opt.trace = counts ? trace_open(path, format, THREADS, STEPS, opt.seed) : NULL;
+    BatchResult res;
+    bool ok = opt.trace && simulator_run_batch(b, GAMES, STEPS, &opt, &res);
+    if (ok) batch_result_free(&res);
+    ok = trace_close(opt.trace) && ok;
+
+    int replayed = 0;
+    FILE *f = ok ? fopen(path, "r") : NULL;
+    if (f && format == TRACE_BINARY) {
+        TraceFileHeader h;
+        TraceRecord r;
+        ok = fread(&h, sizeof(h), 1, f) == 1 && h.version == TRACE_VERSION &&
+             h.record_size == sizeof(TraceRecord) && h.max_steps == STEPS;
+        while (ok && fread(&r, sizeof(r), 1, f) == 1) {
+            ok = replays(b, &r, STEPS, counts);
+            replayed++;
+        }
+    } else if (f) {
+        char line[256];
+        ok = fgets(line, sizeof(line), f) && strcmp(line, "board,game,won,rolls,conn_hits,rng0,rng1,rng2,rng3\n") == 0;
+        while (ok && fgets(line, sizeof(line), f)) {
+            TraceRecord r;
+            unsigned won;
+            ok = sscanf(line, "%" SCNu32 ",%" SCNu32 ",%u,%" SCNu32 ",%" SCNu32 ",%" SCNu64 ",%" SCNu64 ",%" SCNu64 ",%" SCNu64,
+                        &r.board, &r.game, &won, &r.rolls, &r.conn_hits,
+                        &r.start[0], &r.start[1], &r.start[2], &r.start[3]) == 9 &&
+                 won == (r.rolls != 0) && replays(b, &r, STEPS, counts);
+            replayed++;
+        }
+    }
+    if (f) fclose(f);
+    remove(path);
+    free(counts);
+    destroy_board(b);
+    return ok && f ? replayed : -1;
+}
+
+static bool test_trace_replay_binary(void) {
+    CHECK(trace_and_replay(TRACE_BINARY, SIM_ENGINE_SCALAR) == 5000);
+    CHECK(trace_and_replay(TRACE_BINARY, SIM_ENGINE_LOCKSTEP) == 5000);
+    return true;
+}
+
+static bool test_trace_replay_csv(void) {
+    CHECK(trace_and_replay(TRACE_CSV, SIM_ENGINE_SCALAR) == 5000);
+    CHECK(trace_and_replay(TRACE_CSV, SIM_ENGINE_LOCKSTEP) == 5000);
+    return true;
+}
+
+int main(void) {
+    run_test("shards merge to the plain run (scalar)", test_shards_scalar);
+    run_test("shards merge to the plain run (lockstep)", test_shards_lockstep);
+    run_test("multiplayer ignores the thread count", test_multiplayer_threads);
+    run_test("traced games replay (binary)", test_trace_replay_binary);
+    run_test("traced games replay (csv)", test_trace_replay_csv);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
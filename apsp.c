@@ -0,0 +1,362 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "apsp.h"
+
+// large enough for any path, small enough that two of them still add up
+#define FW_INF (INT64_MAX / 4)
+
+/* Barrier whose number of threads is only fixed once they have been
+ * started, so a thread that can not be created just leaves the work to
+ * the others
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int count;        // threads to wait for, 0 while unknown
+    int waiting;
+    unsigned generation;
+} Barrier;
+
+static void barrier_wait(Barrier *b) {
+    pthread_mutex_lock(&b->lock);
+    unsigned generation = b->generation;
+    if (++b->waiting == b->count) {
+        b->waiting = 0;
+        b->generation++;
+        pthread_cond_broadcast(&b->cond);
+    } else {
+        while (generation == b->generation) pthread_cond_wait(&b->cond, &b->lock);
+    }
+    pthread_mutex_unlock(&b->lock);
+}
+
+static void barrier_set_count(Barrier *b, int count) {
+    pthread_mutex_lock(&b->lock);
+    b->count = count;
+    if (b->waiting == count) {
+        b->waiting = 0;
+        b->generation++;
+        pthread_cond_broadcast(&b->cond);
+    }
+    pthread_mutex_unlock(&b->lock);
+}
+
+typedef struct {
+    int64_t *dist;
+    int n;
+    int tile;
+    int num_tiles;
+    int num_workers;    // set before the first barrier is passed
+    bool negative;      // negative cycle found
+    Barrier barrier;
+} FloydWarshall;
+
+typedef struct {
+    FloydWarshall *fw;
+    int id;
+} FwWorker;
+
+// relaxes tile (ib, jb) over the k of tile kb
+static void fw_tile(const FloydWarshall *fw, int kb, int ib, int jb) {
+    size_t n = (size_t)fw->n;
+    int k0 = kb * fw->tile, k1 = k0 + fw->tile < fw->n ? k0 + fw->tile : fw->n;
+    int i0 = ib * fw->tile, i1 = i0 + fw->tile < fw->n ? i0 + fw->tile : fw->n;
+    int j0 = jb * fw->tile, j1 = j0 + fw->tile < fw->n ? j0 + fw->tile : fw->n;
+    for (int k = k0; k < k1; k++) {
+        const int64_t *row_k = fw->dist + k * n;
+        for (int i = i0; i < i1; i++) {
+            int64_t *row_i = fw->dist + i * n;
+            int64_t dik = row_i[k];
+            if (dik >= FW_INF) continue;
+            for (int j = j0; j < j1; j++) {
+                int64_t via = dik + row_k[j];
+                row_i[j] = via < row_i[j] ? via : row_i[j];
+            }
+        }
+    }
+}
+
+static bool fw_negative_diagonal(const FloydWarshall *fw) {
+    for (size_t i = 0; i < (size_t)fw->n; i++) {
+        if (fw->dist[i * fw->n + i] < 0) return true;
+    }
+    return false;
+}
+
+/* Every block kb of k takes three phases: the diagonal tile, then the
+ * tiles in its row and column (they only need the diagonal one), then all
+ * other tiles (they need their row and column tile).
+ */
+static void *fw_worker_run(void *arg) {
+    FwWorker *w = arg;
+    FloydWarshall *fw = w->fw;
+    int nt = fw->num_tiles;
+    barrier_wait(&fw->barrier); // num_workers is known from here on
+    int step = fw->num_workers;
+
+    for (int kb = 0; kb < nt; kb++) {
+        if (w->id == 0) {
+            fw->negative = fw_negative_diagonal(fw);
+            if (!fw->negative) fw_tile(fw, kb, kb, kb);
+        }
+        barrier_wait(&fw->barrier);
+        if (fw->negative) break;
+
+        for (int t = w->id; t < 2 * (nt - 1); t += step) {
+            int other = t / 2 < kb ? t / 2 : t / 2 + 1;
+            if (t % 2) fw_tile(fw, kb, kb, other);
+            else fw_tile(fw, kb, other, kb);
+        }
+        barrier_wait(&fw->barrier);
+
+        // whole tile rows per thread, so a thread keeps its rows in cache
+        for (int ib = w->id; ib < nt; ib += step) {
+            if (ib == kb) continue;
+            for (int jb = 0; jb < nt; jb++) {
+                if (jb != kb) fw_tile(fw, kb, ib, jb);
+            }
+        }
+        barrier_wait(&fw->barrier);
+    }
+    return NULL;
+}
+
+ApspStatus apsp_floyd_warshall(const GraphDense *g, int tile, int num_threads, int64_t *dist) {
+    if (!g || !dist || tile < 1 || num_threads < 1) return APSP_NO_MEMORY;
+    size_t n = (size_t)g->num_nodes;
+    for (size_t i = 0; i < n * n; i++) {
+        dist[i] = g->cells[i] != 0 ? g->cells[i] : FW_INF;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (dist[i * n + i] > 0) dist[i * n + i] = 0;
+    }
+
+    FloydWarshall fw = {
+        .dist = dist,
+        .n = (int)n,
+        .tile = tile,
+        .num_tiles = (int)((n + (size_t)tile - 1) / (size_t)tile),
+        .barrier = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0},
+    };
+    FwWorker *workers = malloc(sizeof(FwWorker) * (size_t)num_threads);
+    pthread_t *threads = malloc(sizeof(pthread_t) * (size_t)num_threads);
+    if (!workers || !threads) {
+        perror("malloc");
+        free(workers);
+        free(threads);
+        return APSP_NO_MEMORY;
+    }
+
+    // thread 0 is the calling thread
+    int started = 1;
+    for (int t = 1; t < num_threads; t++) {
+        workers[started] = (FwWorker){&fw, started};
+        if (pthread_create(&threads[started], NULL, fw_worker_run, &workers[started]) == 0) started++;
+    }
+    fw.num_workers = started;
+    barrier_set_count(&fw.barrier, started);
+    workers[0] = (FwWorker){&fw, 0};
+    fw_worker_run(&workers[0]);
+    for (int t = 1; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(workers);
+    free(threads);
+
+    if (fw.negative || fw_negative_diagonal(&fw)) return APSP_NEGATIVE_CYCLE;
+    // paths through unreachable nodes may have come down from FW_INF a little
+    for (size_t i = 0; i < n * n; i++) {
+        if (dist[i] >= FW_INF / 2) dist[i] = APSP_INF;
+    }
+    return APSP_OK;
+}
+
+/* Potentials h with w(u, v) + h(u) - h(v) >= 0 for every edge: distances
+ * from a virtual source with a 0 edge to every node, found by queue based
+ * Bellman-Ford. A node relaxed n times lies on a negative cycle.
+ */
+static ApspStatus johnson_potentials(const GraphCSR *g, int64_t *h) {
+    int n = g->num_nodes;
+    int *queue = malloc(sizeof(int) * (size_t)(n ? n : 1));
+    bool *queued = malloc(sizeof(bool) * (size_t)(n ? n : 1));
+    int *relaxed = calloc((size_t)(n ? n : 1), sizeof(int));
+    if (!queue || !queued || !relaxed) {
+        perror("malloc");
+        free(queue);
+        free(queued);
+        free(relaxed);
+        return APSP_NO_MEMORY;
+    }
+
+    // circular queue, a node is at most once in it
+    int head = 0, size = n;
+    for (int v = 0; v < n; v++) {
+        h[v] = 0;
+        queue[v] = v;
+        queued[v] = true;
+    }
+    ApspStatus status = APSP_OK;
+    while (size > 0 && status == APSP_OK) {
+        int u = queue[head];
+        head = head + 1 == n ? 0 : head + 1;
+        size--;
+        queued[u] = false;
+        for (size_t k = g->row_start[u]; k < g->row_start[u + 1]; k++) {
+            int v = g->col[k];
+            int64_t d = h[u] + g->weight[k];
+            if (d >= h[v]) continue;
+            h[v] = d;
+            if (++relaxed[v] >= n) {
+                status = APSP_NEGATIVE_CYCLE;
+                break;
+            }
+            if (!queued[v]) {
+                queued[v] = true;
+                int tail = head + size < n ? head + size : head + size - n;
+                queue[tail] = v;
+                size++;
+            }
+        }
+    }
+    free(queue);
+    free(queued);
+    free(relaxed);
+    return status;
+}
+
+typedef struct {
+    int64_t dist;
+    int node;
+} HeapItem;
+
+typedef struct {
+    const GraphCSR *g;
+    const int64_t *h;
+    const int *sources;
+    int num_sources;
+    int64_t *dist;
+    atomic_int next_source;
+} Johnson;
+
+typedef struct {
+    Johnson *job;
+    bool ok;
+} JohnsonWorker;
+
+static void heap_push(HeapItem *heap, size_t *size, HeapItem item) {
+    size_t i = (*size)++;
+    while (i > 0 && heap[(i - 1) / 2].dist > item.dist) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = item;
+}
+
+static HeapItem heap_pop(HeapItem *heap, size_t *size) {
+    HeapItem top = heap[0];
+    HeapItem last = heap[--(*size)];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= *size) break;
+        if (c + 1 < *size && heap[c + 1].dist < heap[c].dist) c++;
+        if (heap[c].dist >= last.dist) break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    if (*size > 0) heap[i] = last;
+    return top;
+}
+
+// Dijkstra on the reweighted graph from the sources pulled off the job
+static void *johnson_worker_run(void *arg) {
+    JohnsonWorker *w = arg;
+    Johnson *job = w->job;
+    const GraphCSR *g = job->g;
+    size_t n = (size_t)g->num_nodes;
+    // lazy deletion: a node is pushed once per improvement, at most once per entry
+    HeapItem *heap = malloc(sizeof(HeapItem) * (g->num_entries + 1));
+    bool *done = malloc(sizeof(bool) * (n ? n : 1));
+    w->ok = heap && done;
+
+    int s;
+    while (w->ok && (s = atomic_fetch_add(&job->next_source, 1)) < job->num_sources) {
+        int src = job->sources ? job->sources[s] : s;
+        int64_t *row = job->dist + (size_t)s * n;
+        for (size_t v = 0; v < n; v++) {
+            row[v] = APSP_INF;
+            done[v] = false;
+        }
+        size_t size = 0;
+        row[src] = 0;
+        heap_push(heap, &size, (HeapItem){0, src});
+        while (size > 0) {
+            HeapItem top = heap_pop(heap, &size);
+            int u = top.node;
+            if (done[u]) continue;
+            done[u] = true;
+            for (size_t k = g->row_start[u]; k < g->row_start[u + 1]; k++) {
+                int v = g->col[k];
+                int64_t d = top.dist + g->weight[k] + job->h[u] - job->h[v];
+                if (d < row[v]) {
+                    row[v] = d;
+                    heap_push(heap, &size, (HeapItem){d, v});
+                }
+            }
+        }
+        // back to the original weights
+        for (size_t v = 0; v < n; v++) {
+            if (row[v] != APSP_INF) row[v] += job->h[v] - job->h[src];
+        }
+    }
+    free(heap);
+    free(done);
+    return NULL;
+}
+
+ApspStatus apsp_johnson(const GraphCSR *g, const int *sources, int num_sources, int num_threads, int64_t *dist) {
+    if (!g || !dist || num_threads < 1) return APSP_NO_MEMORY;
+    if (!sources) num_sources = g->num_nodes;
+    int64_t *h = malloc(sizeof(int64_t) * (size_t)(g->num_nodes ? g->num_nodes : 1));
+    if (!h) {
+        perror("malloc");
+        return APSP_NO_MEMORY;
+    }
+    ApspStatus status = johnson_potentials(g, h);
+    if (status != APSP_OK) {
+        free(h);
+        return status;
+    }
+
+    Johnson job = {g, h, sources, num_sources, dist, 0};
+    JohnsonWorker *workers = malloc(sizeof(JohnsonWorker) * (size_t)num_threads);
+    pthread_t *threads = malloc(sizeof(pthread_t) * (size_t)num_threads);
+    bool *started = calloc((size_t)num_threads, sizeof(bool));
+    if (!workers || !threads || !started) {
+        perror("malloc");
+        status = APSP_NO_MEMORY;
+    } else {
+        // worker 0 runs on the calling thread, as does a worker whose thread can not be started
+        for (int t = 0; t < num_threads; t++) workers[t] = (JohnsonWorker){&job, false};
+        for (int t = 1; t < num_threads; t++) {
+            started[t] = pthread_create(&threads[t], NULL, johnson_worker_run, &workers[t]) == 0;
+        }
+        johnson_worker_run(&workers[0]);
+        for (int t = 1; t < num_threads; t++) {
+            if (started[t]) pthread_join(threads[t], NULL);
+            else johnson_worker_run(&workers[t]);
+        }
+        // the sources of a worker without memory are left to the others
+        bool any_ok = false;
+        for (int t = 0; t < num_threads; t++) any_ok = any_ok || workers[t].ok;
+        if (!any_ok) status = APSP_NO_MEMORY;
+    }
+    free(workers);
+    free(threads);
+    free(started);
+    free(h);
+    return status;
+}
@@ -0,0 +1,40 @@
+#ifndef APSP_H
+#define APSP_H
+
+#include <stdint.h>
+#include "graph.h"
+
+/* All-pairs shortest paths over a graph from graph.h: a non-zero cell
+ * [u][v] is an edge u -> v with that weight. With the +w/-w convention
+ * every edge has a reverse edge of the negated weight, so a graph only
+ * has shortest paths if all of its cycles add up to at least 0 (e.g.
+ * weights w(u, v) = p(v) - p(u) for some potential p).
+ *
+ * dist is row-major, dist[s * num_nodes + v] is the distance from s to v,
+ * APSP_INF if v can not be reached.
+ */
+#define APSP_INF INT64_MAX
+
+typedef enum {
+    APSP_OK,
+    APSP_NEGATIVE_CYCLE,   // dist is not valid
+    APSP_NO_MEMORY
+} ApspStatus;
+
+/* Floyd-Warshall over the dense matrix in tile x tile blocks, so every
+ * round over k works on blocks that stay in cache; the blocks of a phase
+ * are shared out among num_threads threads. Negative cycles are detected
+ * after every block of k, before the distances can run away.
+ * dist has num_nodes^2 entries.
+ */
+ApspStatus apsp_floyd_warshall(const GraphDense *g, int tile, int num_threads, int64_t *dist);
+
+/* Johnson's algorithm for sparse graphs: Bellman-Ford (queue based) finds
+ * potentials that make all weights non-negative or a negative cycle, then
+ * num_threads threads run Dijkstra from the sources. sources lists
+ * num_sources nodes (NULL = every node, num_sources is then ignored);
+ * dist has one row of num_nodes entries per source.
+ */
+ApspStatus apsp_johnson(const GraphCSR *g, const int *sources, int num_sources, int num_threads, int64_t *dist);
+
+#endif // APSP_H
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "graph.h"
+#include "apsp.h"
+
+/* Benchmark of apsp.h on random graphs: weights w(u, v) = p(v) - p(u) for
+ * random potentials p, so the +w/-w graph has no negative cycle and every
+ * distance is known. Floyd-Warshall runs over tile sizes and thread
+ * counts, Johnson over thread counts, and both are checked against p.
+ *
+ * Usage: apsp_bench [max_nodes] [max_threads]
+ */
+
+#define EDGES_PER_NODE 4
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static double seconds_since(const struct timespec *t0) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec - t0->tv_sec) + (t.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+/* a path 0 - 1 - ... - n-1 keeps the graph connected, the other edges are
+ * random pairs; potentials are distinct so no weight is 0
+ */
+static Edge *random_edges(int n, int *potential, size_t *count, uint64_t seed) {
+    size_t m = (size_t)n * EDGES_PER_NODE;
+    Edge *edges = malloc(sizeof(Edge) * m);
+    if (!edges) return NULL;
+    for (int v = 0; v < n; v++) {
+        potential[v] = v * 7 + (int)(splitmix64(&seed) % 7);
+    }
+    size_t k = 0;
+    for (int v = 1; v < n; v++) {
+        edges[k++] = (Edge){v - 1, v, potential[v] - potential[v - 1]};
+    }
+    while (k < m) {
+        int u = (int)(splitmix64(&seed) % (uint64_t)n);
+        int v = (int)(splitmix64(&seed) % (uint64_t)n);
+        if (u != v) edges[k++] = (Edge){u, v, potential[v] - potential[u]};
+    }
+    *count = m;
+    return edges;
+}
+
+// every distance must be p(v) - p(u)
+static bool check(const int64_t *dist, const int *potential, int n) {
+    for (int u = 0; u < n; u++) {
+        for (int v = 0; v < n; v++) {
+            if (dist[(size_t)u * n + v] != (int64_t)potential[v] - potential[u]) return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int max_nodes = 1024;
+    long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) max_threads = 1;
+    if (argc > 1) {
+        char *end;
+        errno = 0;
+        long val = strtol(argv[1], &end, 10);
+        if (errno || *end != '\0' || val < 2 || val > 16384) {
+            fprintf(stderr, "Error: max_nodes must be 2-16384 (got '%s')\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+        max_nodes = (int)val;
+    }
+    if (argc > 2) {
+        char *end;
+        errno = 0;
+        max_threads = strtol(argv[2], &end, 10);
+        if (errno || *end != '\0' || max_threads < 1 || max_threads > 1024) {
+            fprintf(stderr, "Error: max_threads must be 1-1024 (got '%s')\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    static const int tiles[] = {16, 32, 64, 128, 256};
+    printf("%7s  %-10s  %6s  %7s  %10s  %9s  %s\n", "nodes", "algorithm", "tile", "threads", "seconds", "Gupdates/s", "check");
+    for (int n = 128; n <= max_nodes; n *= 2) {
+        int *potential = malloc(sizeof(int) * (size_t)n);
+        int64_t *dist = malloc(sizeof(int64_t) * (size_t)n * n);
+        size_t edge_count = 0;
+        Edge *edges = potential ? random_edges(n, potential, &edge_count, (uint64_t)n) : NULL;
+        GraphCSR csr;
+        GraphDense dense;
+        if (!dist || !edges || !graph_csr_build(&csr, n, edges, edge_count, NULL, NULL)) {
+            perror("malloc");
+            return EXIT_FAILURE;
+        }
+        if (!graph_dense_from_csr(&dense, &csr)) {
+            graph_csr_free(&csr);
+            return EXIT_FAILURE;
+        }
+
+        double updates = (double)n * n * n;
+        for (size_t i = 0; i < sizeof(tiles) / sizeof(tiles[0]); i++) {
+            if (tiles[i] > n) break;
+            for (int threads = 1; threads <= max_threads; threads *= 2) {
+                struct timespec t0;
+                clock_gettime(CLOCK_MONOTONIC, &t0);
+                ApspStatus status = apsp_floyd_warshall(&dense, tiles[i], threads, dist);
+                double seconds = seconds_since(&t0);
+                printf("%7d  %-10s  %6d  %7d  %10.4f  %9.2f  %s\n", n, "floyd", tiles[i], threads,
+                       seconds, updates / seconds / 1e9, status == APSP_OK && check(dist, potential, n) ? "ok" : "FAILED");
+            }
+        }
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            struct timespec t0;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            ApspStatus status = apsp_johnson(&csr, NULL, 0, threads, dist);
+            double seconds = seconds_since(&t0);
+            printf("%7d  %-10s  %6s  %7d  %10.4f  %9s  %s\n", n, "johnson", "-", threads, seconds, "-",
+                   status == APSP_OK && check(dist, potential, n) ? "ok" : "FAILED");
+        }
+
+        // any other weight on one edge gives it or its reverse a negative cycle
+        edges[edge_count - 1].weight *= 2;
+        GraphCSR cyclic;
+        if (graph_csr_build(&cyclic, n, edges, edge_count, NULL, NULL)) {
+            GraphDense cyclic_dense;
+            bool fw_found = graph_dense_from_csr(&cyclic_dense, &cyclic) &&
+                            apsp_floyd_warshall(&cyclic_dense, 64, (int)max_threads, dist) == APSP_NEGATIVE_CYCLE;
+            bool johnson_found = apsp_johnson(&cyclic, NULL, 0, (int)max_threads, dist) == APSP_NEGATIVE_CYCLE;
+            printf("%7d  negative cycle found: floyd %s, johnson %s\n", n, fw_found ? "ok" : "FAILED", johnson_found ? "ok" : "FAILED");
+            graph_dense_free(&cyclic_dense);
+            graph_csr_free(&cyclic);
+        }
+
+        graph_dense_free(&dense);
+        graph_csr_free(&csr);
+        free(edges);
+        free(dist);
+        free(potential);
+    }
+    return EXIT_SUCCESS;
+}
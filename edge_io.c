@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "edge_io.h"
+
+/* Work of one thread on the bytes [begin, end) of the file (text) or the
+ * edges [first, first + count) (binary)
+ */
+typedef struct {
+    const char *begin;
+    const char *end;
+    size_t first_line;      // lines before begin
+    size_t lines;           // counted in the first pass
+    Edge *out;              // parse target, room for lines edges
+    size_t count;           // edges parsed
+    size_t malformed;
+    size_t first_malformed;
+    int max_node;
+} Chunk;
+
+static bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+/* integer at *p (before end), false if there is none or it does not fit an
+ * int; INT_MIN is refused too, the graph stores every weight negated as well
+ */
+static bool parse_int(const char **p, const char *end, int *value) {
+    const char *s = *p;
+    bool negative = s < end && *s == '-';
+    if (s < end && (*s == '-' || *s == '+')) s++;
+    if (s == end || *s < '0' || *s > '9') return false;
+    long long v = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        v = v * 10 + (*s++ - '0');
+        if (v > INT_MAX) return false;
+    }
+    *value = negative ? -(int)v : (int)v;
+    *p = s;
+    return true;
+}
+
+// one line without its '\n': 1 = edge, 0 = nothing to parse, -1 = malformed
+static int parse_line(const char *p, const char *end, Edge *edge) {
+    while (p < end && is_separator(*p)) p++;
+    if (p == end || *p == '#') return 0;
+    int field[3];
+    for (int i = 0; i < 3; i++) {
+        if (i > 0) {
+            const char *s = p;
+            while (p < end && is_separator(*p)) p++;
+            if (p == s) return -1;
+        }
+        if (!parse_int(&p, end, &field[i])) return -1;
+    }
+    while (p < end && is_separator(*p)) p++;
+    if (p != end) return -1;
+    *edge = (Edge){field[0], field[1], field[2]};
+    return 1;
+}
+
+static void *chunk_count_lines(void *arg) {
+    Chunk *c = arg;
+    size_t lines = 0;
+    const char *p = c->begin;
+    while (p < c->end) {
+        const char *nl = memchr(p, '\n', (size_t)(c->end - p));
+        lines++;
+        if (!nl) break;
+        p = nl + 1;
+    }
+    c->lines = lines;
+    return NULL;
+}
+
+static void *chunk_parse(void *arg) {
+    Chunk *c = arg;
+    c->count = 0;
+    c->malformed = 0;
+    c->max_node = -1;
+    const char *p = c->begin;
+    for (size_t line = 0; p < c->end; line++) {
+        const char *nl = memchr(p, '\n', (size_t)(c->end - p));
+        const char *line_end = nl ? nl : c->end;
+        Edge *e = &c->out[c->count];
+        int r = parse_line(p, line_end, e);
+        if (r > 0) {
+            c->count++;
+            if (e->from > c->max_node) c->max_node = e->from;
+            if (e->to > c->max_node) c->max_node = e->to;
+        } else if (r < 0 && c->malformed++ == 0) {
+            c->first_malformed = c->first_line + line + 1;
+        }
+        if (!nl) break;
+        p = nl + 1;
+    }
+    return NULL;
+}
+
+static void *chunk_max_node(void *arg) {
+    Chunk *c = arg;
+    int max_node = -1;
+    for (size_t i = 0; i < c->count; i++) {
+        int m = c->out[i].from > c->out[i].to ? c->out[i].from : c->out[i].to;
+        max_node = m > max_node ? m : max_node;
+    }
+    c->max_node = max_node;
+    return NULL;
+}
+
+/* Runs fn on every chunk; chunk 0 runs on the calling thread, as does any
+ * chunk whose thread can not be started
+ */
+static void run_chunks(void *(*fn)(void *), Chunk *chunks, int num_chunks) {
+    pthread_t threads[num_chunks];
+    bool started[num_chunks];
+    for (int t = 1; t < num_chunks; t++) {
+        started[t] = pthread_create(&threads[t], NULL, fn, &chunks[t]) == 0;
+    }
+    fn(&chunks[0]);
+    for (int t = 1; t < num_chunks; t++) {
+        if (started[t]) pthread_join(threads[t], NULL);
+        else fn(&chunks[t]);
+    }
+}
+
+static bool load_binary(const char *path, const char *data, size_t size, int num_threads, EdgeList *out) {
+    EdgeFileHeader h;
+    memcpy(&h, data, sizeof(h));
+    if (h.count != (size - sizeof(h)) / sizeof(Edge) || (size - sizeof(h)) % sizeof(Edge) != 0) {
+        fprintf(stderr, "%s: damaged edge file (%llu edges in the header)\n", path, (unsigned long long)h.count);
+        return false;
+    }
+    // the mapping is page aligned, so the records after the header are aligned too
+    out->edges = (Edge *)(void *)(data + sizeof(h));
+    out->count = (size_t)h.count;
+
+    Chunk chunks[num_threads];
+    for (int t = 0; t < num_threads; t++) {
+        size_t first = out->count * (size_t)t / (size_t)num_threads;
+        size_t last = out->count * (size_t)(t + 1) / (size_t)num_threads;
+        chunks[t] = (Chunk){.out = out->edges + first, .count = last - first};
+    }
+    run_chunks(chunk_max_node, chunks, num_threads);
+    for (int t = 0; t < num_threads; t++) {
+        if (chunks[t].max_node > out->max_node) out->max_node = chunks[t].max_node;
+    }
+    return true;
+}
+
+static bool load_text(const char *data, size_t size, int num_threads, EdgeList *out) {
+    // chunks end after a '\n', so no line is split
+    Chunk chunks[num_threads];
+    const char *end = data + size;
+    const char *begin = data;
+    for (int t = 0; t < num_threads; t++) {
+        const char *stop = t + 1 == num_threads ? end : data + size * (size_t)(t + 1) / (size_t)num_threads;
+        if (stop < begin) stop = begin;
+        if (stop < end) {
+            const char *nl = memchr(stop, '\n', (size_t)(end - stop));
+            stop = nl ? nl + 1 : end;
+        }
+        chunks[t] = (Chunk){.begin = begin, .end = stop};
+        begin = stop;
+    }
+    run_chunks(chunk_count_lines, chunks, num_threads);
+
+    size_t lines = 0;
+    for (int t = 0; t < num_threads; t++) {
+        chunks[t].first_line = lines;
+        lines += chunks[t].lines;
+    }
+    out->edges = malloc(sizeof(Edge) * (lines ? lines : 1));
+    if (!out->edges) {
+        perror("malloc");
+        return false;
+    }
+    out->edges_owned = true;
+    for (int t = 0; t < num_threads; t++) {
+        chunks[t].out = out->edges + chunks[t].first_line;
+    }
+    run_chunks(chunk_parse, chunks, num_threads);
+
+    // close the gaps left by comments and malformed lines, keeping the order
+    for (int t = 0; t < num_threads; t++) {
+        if (chunks[t].out != out->edges + out->count) {
+            memmove(out->edges + out->count, chunks[t].out, sizeof(Edge) * chunks[t].count);
+        }
+        out->count += chunks[t].count;
+        if (chunks[t].max_node > out->max_node) out->max_node = chunks[t].max_node;
+        if (chunks[t].malformed > 0 && out->malformed == 0) out->first_malformed = chunks[t].first_malformed;
+        out->malformed += chunks[t].malformed;
+    }
+    return true;
+}
+
+bool edge_list_load(const char *path, int num_threads, EdgeList *out) {
+    if (!path || !out || num_threads < 1) return false;
+    memset(out, 0, sizeof(*out));
+    out->max_node = -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(path);
+        close(fd);
+        return false;
+    }
+    out->bytes = (size_t)st.st_size;
+    if (out->bytes == 0) {
+        close(fd);
+        return true;
+    }
+    out->map = mmap(NULL, out->bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (out->map == MAP_FAILED) {
+        perror(path);
+        out->map = NULL;
+        return false;
+    }
+    posix_madvise(out->map, out->bytes, POSIX_MADV_SEQUENTIAL);
+
+    // small files get one thread, a chunk should be worth starting a thread for
+    size_t min_chunk = 1 << 20;
+    if ((size_t)num_threads > out->bytes / min_chunk) {
+        num_threads = out->bytes / min_chunk > 0 ? (int)(out->bytes / min_chunk) : 1;
+    }
+
+    const char *data = out->map;
+    bool ok = out->bytes >= sizeof(EdgeFileHeader) && memcmp(data, EDGE_FILE_MAGIC, 8) == 0
+              ? load_binary(path, data, out->bytes, num_threads, out)
+              : load_text(data, out->bytes, num_threads, out);
+    if (!ok) edge_list_free(out);
+    return ok;
+}
+
+void edge_list_free(EdgeList *list) {
+    if (!list) return;
+    if (list->edges_owned) free(list->edges);
+    if (list->map) munmap(list->map, list->bytes);
+    list->edges = NULL;
+    list->map = NULL;
+    list->count = 0;
+}
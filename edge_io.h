@@ -0,0 +1,42 @@
+#ifndef EDGE_IO_H
+#define EDGE_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "graph.h"
+
+/* Edge list files, mapped with mmap:
+ *  - binary: EdgeFileHeader, then count Edge records (three native int32);
+ *    the edges are used in place, without a copy
+ *  - text: one "from to weight" per line, separated by blanks or commas;
+ *    empty lines and lines starting with '#' are skipped, a value outside
+ *    -INT_MAX..INT_MAX makes the line malformed
+ * Text files are split into one chunk per thread at line boundaries: the
+ * threads count the lines of their chunk, then parse it straight into its
+ * place in the edge array.
+ */
+#define EDGE_FILE_MAGIC "EDGES001"
+
+typedef struct {
+    char magic[8];          // EDGE_FILE_MAGIC, not terminated
+    uint64_t count;
+} EdgeFileHeader;
+
+typedef struct {
+    Edge *edges;
+    size_t count;
+    int max_node;           // largest endpoint, -1 without edges
+    size_t malformed;       // text lines that are no edge, skipped
+    size_t first_malformed; // line number (1-based) of the first one
+    size_t bytes;           // file size
+
+    void *map;              // mapping of the file
+    bool edges_owned;       // edges were allocated, not mapped
+} EdgeList;
+
+// false with a message if path can not be read or is a damaged binary file
+bool edge_list_load(const char *path, int num_threads, EdgeList *out);
+void edge_list_free(EdgeList *list);
+
+#endif // EDGE_IO_H
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include "graph.h"
+
+typedef struct {
+    int row;
+    int col;
+    int weight;
+} Entry;
+
+/* Distributes n entries from src to dst by key (col or row) with a counting
+ * sort; stable, so sorting by column and then by row gives sorted rows.
+ * count has num_nodes + 1 entries and ends up as the start of every key.
+ */
+static void entries_sort(const Entry *src, Entry *dst, size_t n, size_t *count, int num_nodes, bool by_row) {
+    for (int i = 0; i <= num_nodes; i++) count[i] = 0;
+    for (size_t i = 0; i < n; i++) {
+        count[(by_row ? src[i].row : src[i].col) + 1]++;
+    }
+    for (int i = 0; i < num_nodes; i++) count[i + 1] += count[i];
+    for (size_t i = 0; i < n; i++) {
+        int key = by_row ? src[i].row : src[i].col;
+        dst[count[key]++] = src[i];
+    }
+    // count[key] now ends every key, shift back to the starts
+    for (int i = num_nodes; i > 0; i--) count[i] = count[i - 1];
+    count[0] = 0;
+}
+
+bool graph_csr_build(GraphCSR *g, int num_nodes, const Edge *edges, size_t edge_count, GraphEdgeStatus *status, GraphBuildStats *stats) {
+    if (!g || num_nodes < 0 || (!edges && edge_count > 0)) return false;
+    *g = (GraphCSR){.num_nodes = num_nodes};
+    GraphBuildStats counted = {0, 0, 0, 0};
+
+    // bucket the valid edges by their smaller endpoint, in edge order
+    size_t *bucket = calloc((size_t)num_nodes + 1, sizeof(size_t));
+    if (!bucket) return false;
+    size_t valid = 0;
+    for (size_t i = 0; i < edge_count; i++) {
+        int f = edges[i].from;
+        int t = edges[i].to;
+        if (f < 0 || f >= num_nodes || t < 0 || t >= num_nodes || edges[i].weight == INT_MIN) {
+            if (status) status[i] = GRAPH_EDGE_INVALID;
+            if (counted.invalid++ == 0) counted.first_invalid = i;
+            continue;
+        }
+        bucket[(f < t ? f : t) + 1]++;
+        valid++;
+    }
+    for (int u = 0; u < num_nodes; u++) bucket[u + 1] += bucket[u];
+
+    size_t *order = malloc((valid ? valid : 1) * sizeof(size_t));
+    int *stamp = malloc(((size_t)num_nodes ? (size_t)num_nodes : 1) * sizeof(int));
+    int *cell = malloc(((size_t)num_nodes ? (size_t)num_nodes : 1) * sizeof(int));
+    int *touched = malloc((valid ? valid : 1) * sizeof(int));
+    // every pair gives at most two entries
+    Entry *entries = malloc((valid ? 2 * valid : 1) * sizeof(Entry));
+    Entry *sorted = malloc((valid ? 2 * valid : 1) * sizeof(Entry));
+    bool ok = order && stamp && cell && touched && entries && sorted;
+    if (ok) {
+        size_t *next = bucket; // advanced to the bucket ends, restored below
+        for (size_t i = 0; i < edge_count; i++) {
+            int f = edges[i].from;
+            int t = edges[i].to;
+            if (f < 0 || f >= num_nodes || t < 0 || t >= num_nodes || edges[i].weight == INT_MIN) continue;
+            order[next[f < t ? f : t]++] = i;
+        }
+        for (int u = num_nodes; u > 0; u--) bucket[u] = bucket[u - 1];
+        bucket[0] = 0;
+
+        // within bucket u, cell[v] is matrix[u][v] as the edges are applied
+        // in order; stamp[v] == u marks the v seen in this bucket
+        for (int v = 0; v < num_nodes; v++) stamp[v] = -1;
+        size_t num_entries = 0;
+        for (int u = 0; u < num_nodes; u++) {
+            size_t num_touched = 0;
+            for (size_t k = bucket[u]; k < bucket[u + 1]; k++) {
+                const Edge *e = &edges[order[k]];
+                int v = e->from == u ? e->to : e->from;
+                if (stamp[v] != u) {
+                    stamp[v] = u;
+                    cell[v] = 0;
+                    touched[num_touched++] = v;
+                }
+                if (status) status[order[k]] = cell[v] != 0 ? GRAPH_EDGE_OVERWRITE : GRAPH_EDGE_OK;
+                if (cell[v] != 0 && (counted.overwritten++ == 0 || order[k] < counted.first_overwrite)) {
+                    counted.first_overwrite = order[k];
+                }
+                // a self loop is set to w and then to -w
+                cell[v] = (e->from == u && e->to != u) ? e->weight : -e->weight;
+            }
+            for (size_t k = 0; k < num_touched; k++) {
+                int v = touched[k];
+                if (cell[v] == 0) continue;
+                entries[num_entries++] = (Entry){u, v, cell[v]};
+                if (v != u) entries[num_entries++] = (Entry){v, u, -cell[v]};
+            }
+        }
+
+        g->num_entries = num_entries;
+        g->row_start = malloc(((size_t)num_nodes + 1) * sizeof(size_t));
+        g->col = malloc((num_entries ? num_entries : 1) * sizeof(int));
+        g->weight = malloc((num_entries ? num_entries : 1) * sizeof(int));
+        ok = g->row_start && g->col && g->weight;
+        if (ok) {
+            entries_sort(entries, sorted, num_entries, g->row_start, num_nodes, false);
+            entries_sort(sorted, entries, num_entries, g->row_start, num_nodes, true);
+            for (size_t k = 0; k < num_entries; k++) {
+                g->col[k] = entries[k].col;
+                g->weight[k] = entries[k].weight;
+            }
+        }
+    }
+    if (!ok) {
+        perror("malloc");
+        graph_csr_free(g);
+    } else if (stats) {
+        *stats = counted;
+    }
+
+    free(bucket);
+    free(order);
+    free(stamp);
+    free(cell);
+    free(touched);
+    free(entries);
+    free(sorted);
+    return ok;
+}
+
+void graph_csr_free(GraphCSR *g) {
+    if (!g) return;
+    free(g->row_start);
+    free(g->col);
+    free(g->weight);
+    g->row_start = NULL;
+    g->col = NULL;
+    g->weight = NULL;
+    g->num_entries = 0;
+}
+
+bool graph_dense_from_csr(GraphDense *d, const GraphCSR *g) {
+    if (!d || !g) return false;
+    size_t n = (size_t)g->num_nodes;
+    d->num_nodes = g->num_nodes;
+    if (n > 0 && n > SIZE_MAX / sizeof(int) / n) {
+        d->cells = NULL;
+        return false;
+    }
+    // calloc hands out zeroed pages, only the rows with entries get written
+    d->cells = calloc(n ? n * n : 1, sizeof(int));
+    if (!d->cells) {
+        perror("calloc");
+        return false;
+    }
+    for (size_t row = 0; row < n; row++) {
+        for (size_t k = g->row_start[row]; k < g->row_start[row + 1]; k++) {
+            d->cells[row * n + (size_t)g->col[k]] = g->weight[k];
+        }
+    }
+    return true;
+}
+
+void graph_dense_free(GraphDense *d) {
+    if (!d) return;
+    free(d->cells);
+    d->cells = NULL;
+}
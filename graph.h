@@ -0,0 +1,70 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    int from;
+    int to;
+    int weight;
+} Edge;
+
+/* What happened to an edge while building a graph, in the same terms as
+ * filling a dense matrix in edge order: an invalid edge has an endpoint
+ * outside 0..num_nodes-1 or the weight INT_MIN, which has no negation, and
+ * is skipped; an overwriting edge finds
+ * matrix[from][to] already non-zero (set by an earlier edge in either
+ * direction) and replaces it.
+ */
+typedef enum {
+    GRAPH_EDGE_OK,
+    GRAPH_EDGE_INVALID,
+    GRAPH_EDGE_OVERWRITE
+} GraphEdgeStatus;
+
+// Edges skipped and overwritten by a build, with the index of the first one of each
+typedef struct {
+    size_t invalid;
+    size_t overwritten;
+    size_t first_invalid;      // only set if invalid > 0
+    size_t first_overwrite;    // only set if overwritten > 0
+} GraphBuildStats;
+
+/* Sparse graph in CSR form. An edge from -> to with weight w stands for
+ * matrix[from][to] = w and matrix[to][from] = -w (a later edge of the same
+ * pair wins, a self loop ends up as -w); only the non-zero cells are kept,
+ * the columns of every row in ascending order.
+ */
+typedef struct {
+    int num_nodes;
+    size_t num_entries;
+    size_t *row_start;  // num_nodes + 1 offsets into col and weight
+    int *col;
+    int *weight;
+} GraphCSR;
+
+// Dense n x n matrix in one row-major block
+typedef struct {
+    int num_nodes;
+    int *cells;
+} GraphDense;
+
+/* Builds g from edge_count edges in O(num_nodes + edge_count) time and
+ * memory. Repeated pairs are found by bucketing the edges on their smaller
+ * endpoint, so no dense matrix is probed. If status is not NULL it gets one
+ * entry per edge, stats (if not NULL) counts them. Returns false on
+ * allocation failure.
+ */
+bool graph_csr_build(GraphCSR *g, int num_nodes, const Edge *edges, size_t edge_count, GraphEdgeStatus *status, GraphBuildStats *stats);
+void graph_csr_free(GraphCSR *g);
+
+// dense copy of g, false if it does not fit in memory
+bool graph_dense_from_csr(GraphDense *d, const GraphCSR *g);
+void graph_dense_free(GraphDense *d);
+
+static inline int graph_dense_at(const GraphDense *d, int row, int col) {
+    return d->cells[(size_t)row * d->num_nodes + col];
+}
+
+#endif // GRAPH_H
@@ -1,7 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <time.h>
+#include <math.h>
+#include <errno.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
 
 typedef struct point {
     float x;
@@ -27,20 +34,480 @@ Point random_point_in_unit_circle() {
     return p;
 }
 
-float approximate_pi(int num_points) {
-    int inside_circle = 0;
-    for (int i = 0; i < num_points; i++) {
-        Point p = random_point();
-        if (is_point_in_unit_circle(p)) {
-            inside_circle++;
+#define PI 3.14159265358979323846
+
+// Points are generated and tested in blocks, coordinates stored apart (SoA)
+// so the loops over a block compile to SIMD code. Block b holds the points
+// [b * BLOCK_POINTS, (b + 1) * BLOCK_POINTS) of the sequence, whichever
+// worker plays it, so a run does not depend on the number of threads.
+#define BLOCK_BITS 12
+#define BLOCK_POINTS (1 << BLOCK_BITS)
+#define RNG_LANES 8
+// blocks a worker plays between two updates of the shared counters
+#define BLOCKS_PER_REPORT 64
+// base 3 digits of a 64-bit point index
+#define HALTON_DIGITS 41
+// the base 2 coordinates have 32 bits, after 2^32 points the sequences repeat
+#define QMC_MAX_POINTS (1ULL << 32)
+
+typedef struct {
+    float x[BLOCK_POINTS];
+    float y[BLOCK_POINTS];
+} PointBlock;
+
+/* Point sets:
+ *  - SAMPLER_RANDOM: pseudo-random points, error O(1/sqrt(N))
+ *  - SAMPLER_HALTON: Halton sequence in bases 2 and 3
+ *  - SAMPLER_SOBOL: the first two Sobol dimensions, in Gray code order
+ * The low-discrepancy sequences fill the square evenly, so the estimate
+ * converges faster (for the circle's edge roughly O(N^-3/4)).
+ */
+typedef enum {
+    SAMPLER_RANDOM,
+    SAMPLER_HALTON,
+    SAMPLER_SOBOL
+} Sampler;
+
+/* Read-only state shared by the workers. Scrambling applies a random
+ * digital shift to the base 2 coordinates and random digit permutations to
+ * the base 3 one, which keeps the low discrepancy but makes the error of a
+ * run random, like the one of SAMPLER_RANDOM.
+ */
+typedef struct {
+    Sampler sampler;
+    bool scramble;
+    uint64_t seed;
+    uint32_t shift[2];                   // XORed into the base 2 coordinates
+    uint8_t perm3[HALTON_DIGITS][3];     // permutation of each base 3 digit
+    double weight3[HALTON_DIGITS];       // 3^-(k+1)
+    uint32_t low[2][BLOCK_POINTS];       // coordinates of the index bits below BLOCK_BITS
+    uint32_t sobol_v[2][32];             // direction numbers
+} SamplerSpec;
+
+// RNG_LANES independent xorshift128+ generators, advanced side by side
+typedef struct {
+    uint64_t s0[RNG_LANES];
+    uint64_t s1[RNG_LANES];
+} LaneRng;
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void lane_rng_seed(LaneRng *rng, uint64_t seed) {
+    for (int l = 0; l < RNG_LANES; l++) {
+        rng->s0[l] = splitmix64(&seed);
+        rng->s1[l] = splitmix64(&seed) | 1; // never all zero
+    }
+}
+
+static uint32_t reverse_bits(uint32_t v) {
+    uint32_t r = 0;
+    for (int k = 0; k < 32; k++) {
+        r = (r << 1) | ((v >> k) & 1);
+    }
+    return r;
+}
+
+// Sobol (or base 2 Halton) coordinate d of the points with index bits i
+static uint32_t base2_point(const SamplerSpec *spec, int d, uint64_t i) {
+    if (spec->sampler == SAMPLER_HALTON) return reverse_bits((uint32_t)i);
+    uint64_t gray = i ^ (i >> 1);
+    uint32_t v = 0;
+    for (int k = 0; k < 32 && gray; k++, gray >>= 1) {
+        if (gray & 1) v ^= spec->sobol_v[d][k];
+    }
+    return v;
+}
+
+void sampler_init(SamplerSpec *spec, Sampler sampler, bool scramble, uint64_t seed) {
+    memset(spec, 0, sizeof(*spec));
+    spec->sampler = sampler;
+    spec->scramble = scramble;
+    spec->seed = seed;
+
+    // dimension 1 is the van der Corput sequence, dimension 2 comes from x + 1
+    spec->sobol_v[0][0] = spec->sobol_v[1][0] = 1u << 31;
+    for (int k = 1; k < 32; k++) {
+        spec->sobol_v[0][k] = 1u << (31 - k);
+        spec->sobol_v[1][k] = spec->sobol_v[1][k - 1] ^ (spec->sobol_v[1][k - 1] >> 1);
+    }
+
+    uint64_t state = seed;
+    double w = 1.0;
+    for (int k = 0; k < HALTON_DIGITS; k++) {
+        w /= 3;
+        spec->weight3[k] = w;
+        uint8_t *perm = spec->perm3[k];
+        perm[0] = 0, perm[1] = 1, perm[2] = 2;
+        for (int i = 2; scramble && i > 0; i--) {
+            int j = (int)(splitmix64(&state) % (uint64_t)(i + 1));
+            uint8_t t = perm[i];
+            perm[i] = perm[j];
+            perm[j] = t;
+        }
+    }
+    if (scramble) {
+        spec->shift[0] = (uint32_t)splitmix64(&state);
+        spec->shift[1] = (uint32_t)splitmix64(&state);
+    }
+
+    // the index bits of a block and of the points in it do not overlap, so
+    // (in Gray code order too) a point is block part ^ low[d][j]
+    for (int d = 0; d < 2; d++) {
+        for (uint32_t j = 0; j < BLOCK_POINTS; j++) {
+            spec->low[d][j] = base2_point(spec, d, j);
         }
     }
-    return 4.0 * inside_circle / num_points;
 }
-int main() {
-    srand(time(NULL));
-    int num_points = 1000000; // Adjust as needed for accuracy
-    float pi_approximation = approximate_pi(num_points);
+
+static float unit_to_square(uint32_t v) {
+    return (float)(int32_t)(v >> 8) * 0x1p-23f - 1.0f;
+}
+
+// one 64-bit draw per point: the upper 24 bits give x, the next 24 bits y
+void random_points(LaneRng *rng, PointBlock *block) {
+    // local state, so the stores into block can not alias it
+    LaneRng r = *rng;
+    for (int i = 0; i < BLOCK_POINTS; i += RNG_LANES) {
+        for (int l = 0; l < RNG_LANES; l++) {
+            uint64_t s1 = r.s0[l];
+            uint64_t s0 = r.s1[l];
+            uint64_t v = s0 + s1;
+            r.s0[l] = s0;
+            s1 ^= s1 << 23;
+            r.s1[l] = s1 ^ s0 ^ (s1 >> 18) ^ (s0 >> 5);
+            block->x[i + l] = (float)(int32_t)(v >> 40) * 0x1p-23f - 1.0f;
+            block->y[i + l] = (float)(int32_t)((v >> 16) & 0xffffff) * 0x1p-23f - 1.0f;
+        }
+    }
+    *rng = r;
+}
+
+// base 3 coordinates: the digits of the first index are counted up point by point
+static void halton3_points(const SamplerSpec *spec, uint64_t first, float *out) {
+    uint8_t digit[HALTON_DIGITS];
+    double v = 0.0;
+    for (int k = 0; k < HALTON_DIGITS; k++, first /= 3) {
+        digit[k] = (uint8_t)(first % 3);
+        v += spec->perm3[k][digit[k]] * spec->weight3[k];
+    }
+    for (int j = 0; j < BLOCK_POINTS; j++) {
+        out[j] = (float)(v * 2.0 - 1.0);
+        int k = 0;
+        for (; k < HALTON_DIGITS - 1 && digit[k] == 2; k++) {
+            v += (spec->perm3[k][0] - spec->perm3[k][2]) * spec->weight3[k];
+            digit[k] = 0;
+        }
+        v += (spec->perm3[k][digit[k] + 1] - spec->perm3[k][digit[k]]) * spec->weight3[k];
+        digit[k]++;
+    }
+}
+
+// points of block b
+void sample_block(const SamplerSpec *spec, uint64_t b, PointBlock *block) {
+    uint64_t first = b << BLOCK_BITS;
+    if (spec->sampler == SAMPLER_RANDOM) {
+        uint64_t state = spec->seed ^ (b * 0xd1342543de82ef95ULL);
+        LaneRng rng;
+        lane_rng_seed(&rng, splitmix64(&state));
+        random_points(&rng, block);
+        return;
+    }
+
+    uint32_t hi_x = base2_point(spec, 0, first) ^ spec->shift[0];
+    for (int j = 0; j < BLOCK_POINTS; j++) {
+        block->x[j] = unit_to_square(hi_x ^ spec->low[0][j]);
+    }
+    if (spec->sampler == SAMPLER_HALTON) {
+        halton3_points(spec, first, block->y);
+        return;
+    }
+    uint32_t hi_y = base2_point(spec, 1, first) ^ spec->shift[1];
+    for (int j = 0; j < BLOCK_POINTS; j++) {
+        block->y[j] = unit_to_square(hi_y ^ spec->low[1][j]);
+    }
+}
+
+uint64_t count_in_unit_circle(const PointBlock *block) {
+    uint32_t inside = 0;
+    for (int i = 0; i < BLOCK_POINTS; i++) {
+        inside += (block->x[i] * block->x[i] + block->y[i] * block->y[i]) <= 1.0f;
+    }
+    return inside;
+}
+
+// smallest k with (b + 1) * BLOCK_POINTS <= 2^k: block b is part of the first 2^k points
+static int block_level(uint64_t b) {
+    int k = BLOCK_BITS;
+    while (k < 64 && ((b + 1) >> (k - BLOCK_BITS)) > 1) k++;
+    if (k < 64 && ((b + 1) << BLOCK_BITS) > (1ULL << k)) k++;
+    return k;
+}
+
+/* Result of a run: inside[k] counts the hits of the blocks at level k, so
+ * the first 2^k points (k >= BLOCK_BITS) hit the circle sum(inside[..k]) times
+ */
+typedef struct {
+    uint64_t num_points;
+    uint64_t total_inside;
+    uint64_t inside[64];
+} Estimate;
+
+// points played and found inside the circle by all workers so far
+typedef struct {
+    _Atomic uint64_t points;
+    _Atomic uint64_t inside;
+    _Atomic uint64_t next_block;
+    _Atomic uint64_t level_inside[64];
+} Progress;
+
+typedef struct {
+    const SamplerSpec *spec;
+    uint64_t num_points;
+    Progress *progress;
+} Worker;
+
+static void *worker_run(void *arg) {
+    Worker *w = arg;
+    PointBlock *block = aligned_alloc(64, sizeof(PointBlock));
+    if (!block) {
+        perror("aligned_alloc");
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t num_blocks = (w->num_points + BLOCK_POINTS - 1) / BLOCK_POINTS;
+    bool done = false;
+    while (!done) {
+        uint64_t points = 0, inside = 0;
+        for (int n = 0; n < BLOCKS_PER_REPORT; n++) {
+            uint64_t b = atomic_fetch_add(&w->progress->next_block, 1);
+            if (b >= num_blocks) {
+                done = true;
+                break;
+            }
+            sample_block(w->spec, b, block);
+            uint64_t left = w->num_points - (b << BLOCK_BITS);
+            uint64_t hits = 0;
+            if (left >= BLOCK_POINTS) {
+                hits = count_in_unit_circle(block);
+                left = BLOCK_POINTS;
+            } else {
+                // last partial block
+                for (uint64_t i = 0; i < left; i++) {
+                    Point p = {block->x[i], block->y[i]};
+                    hits += is_point_in_unit_circle(p);
+                }
+            }
+            atomic_fetch_add(&w->progress->level_inside[block_level(b)], hits);
+            inside += hits;
+            points += left;
+        }
+        atomic_fetch_add(&w->progress->inside, inside);
+        atomic_fetch_add(&w->progress->points, points);
+    }
+    free(block);
+    return NULL;
+}
+
+static double seconds_since(const struct timespec *t0) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec - t0->tv_sec) + (t.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+/* estimate of pi after points; random points get the binomial standard
+ * error, which says nothing about the error of the low-discrepancy ones
+ */
+static void print_progress(const SamplerSpec *spec, uint64_t points, uint64_t inside, double seconds) {
+    double p = (double)inside / points;
+    double pi = 4.0 * p;
+    printf("%15llu points  pi ~ %.8f", (unsigned long long)points, pi);
+    if (spec->sampler == SAMPLER_RANDOM) printf("  +- %.2e", 4.0 * sqrt(p * (1.0 - p) / points));
+    printf("  %8.1f M points/s\n", points / seconds / 1e6);
+    fflush(stdout);
+}
+
+/* Estimates pi from the first num_points points of spec, played in blocks
+ * by num_threads workers; prints the estimate twice a second and fills out.
+ */
+double approximate_pi(const SamplerSpec *spec, uint64_t num_points, int num_threads, Estimate *out) {
+    Progress *progress = calloc(1, sizeof(Progress));
+    Worker *workers = calloc(num_threads, sizeof(Worker));
+    pthread_t *threads = calloc(num_threads, sizeof(pthread_t));
+    bool *started = calloc(num_threads, sizeof(bool));
+    if (!progress || !workers || !threads || !started) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int t = 0; t < num_threads; t++) {
+        workers[t].spec = spec;
+        workers[t].num_points = num_points;
+        workers[t].progress = progress;
+        started[t] = pthread_create(&threads[t], NULL, worker_run, &workers[t]) == 0;
+        if (!started[t]) worker_run(&workers[t]);
+    }
+
+    const struct timespec tick = {0, 10000000};
+    double next_report = 0.5;
+    while (atomic_load(&progress->points) < num_points) {
+        nanosleep(&tick, NULL);
+        double seconds = seconds_since(&t0);
+        if (seconds >= next_report) {
+            // may be off by the batch a worker adds right now
+            uint64_t inside = atomic_load(&progress->inside);
+            uint64_t points = atomic_load(&progress->points);
+            if (points > 0 && points < num_points) print_progress(spec, points, inside, seconds);
+            next_report += 0.5;
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (started[t]) pthread_join(threads[t], NULL);
+    }
+    out->num_points = num_points;
+    out->total_inside = atomic_load(&progress->inside);
+    for (int k = 0; k < 64; k++) {
+        out->inside[k] = atomic_load(&progress->level_inside[k]);
+    }
+    print_progress(spec, num_points, out->total_inside, seconds_since(&t0));
+
+    free(progress);
+    free(workers);
+    free(threads);
+    free(started);
+    return 4.0 * out->total_inside / num_points;
+}
+
+static const char *sampler_name(const SamplerSpec *spec) {
+    static const char *names[] = {"random", "Halton", "Sobol"};
+    return names[spec->sampler];
+}
+
+/* Error of the estimate after the first 2^k points (and all of them), next
+ * to the one of the pseudo-random run if there is one
+ */
+static void print_checkpoints(const SamplerSpec *spec, const Estimate *est, const Estimate *random) {
+    printf("%15s  %-14s  %-9s", "points", sampler_name(spec), "error");
+    if (random) printf("  %-14s  %-9s  %-9s", "random", "error", "std error");
+    printf("\n");
+
+    uint64_t inside = 0, random_inside = 0;
+    for (int k = BLOCK_BITS; k < 64; k++) {
+        inside += est->inside[k];
+        if (random) random_inside += random->inside[k];
+        uint64_t n = 1ULL << k;
+        bool last = n >= est->num_points;
+        if (last) {
+            n = est->num_points;
+            inside = est->total_inside;
+            if (random) random_inside = random->total_inside;
+        }
+        double pi = 4.0 * inside / n;
+        printf("%15llu  %.12f  %.3e", (unsigned long long)n, pi, fabs(pi - PI));
+        if (random) {
+            double p = (double)random_inside / n;
+            printf("  %.12f  %.3e  %.3e", 4.0 * p, fabs(4.0 * p - PI), 4.0 * sqrt(p * (1.0 - p) / n));
+        }
+        printf("\n");
+        if (last) break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t num_points = 1000000; // Adjust as needed for accuracy
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads < 1) num_threads = 1;
+    Sampler sampler = SAMPLER_RANDOM;
+    bool scramble = false;
+    bool compare = false; // run the pseudo-random points as well, side by side
+    uint64_t seed = (uint64_t)time(NULL);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "q:rcs:")) != -1) {
+        char *end;
+        switch (opt) {
+            case 'q':
+                if (strcmp(optarg, "sobol") == 0) {
+                    sampler = SAMPLER_SOBOL;
+                } else if (strcmp(optarg, "halton") == 0) {
+                    sampler = SAMPLER_HALTON;
+                } else {
+                    fprintf(stderr, "Error: -q requires sobol or halton (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r':
+                scramble = true;
+                break;
+            case 'c':
+                compare = true;
+                break;
+            case 's':
+                errno = 0;
+                seed = strtoull(optarg, &end, 10);
+                if (errno || *end != '\0' || optarg[0] == '-') {
+                    fprintf(stderr, "Error: -s requires a non-negative integer (got '%s')\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-q sobol|halton] [-r] [-c] [-s seed] [points] [threads]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (argc - optind > 2) {
+        fprintf(stderr, "Usage: %s [-q sobol|halton] [-r] [-c] [-s seed] [points] [threads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (compare && sampler == SAMPLER_RANDOM) {
+        sampler = SAMPLER_SOBOL;
+    }
+    if (optind < argc) {
+        char *end;
+        errno = 0;
+        unsigned long long val = strtoull(argv[optind], &end, 10);
+        if (errno || *end != '\0' || argv[optind][0] == '-' || val < 1) {
+            fprintf(stderr, "Error: points must be a positive integer (got '%s')\n", argv[optind]);
+            return EXIT_FAILURE;
+        }
+        num_points = val;
+    }
+    if (sampler != SAMPLER_RANDOM && num_points > QMC_MAX_POINTS) {
+        fprintf(stderr, "Error: -q allows at most %llu points (got %llu)\n",
+                (unsigned long long)QMC_MAX_POINTS, (unsigned long long)num_points);
+        return EXIT_FAILURE;
+    }
+    if (optind + 1 < argc) {
+        char *end;
+        errno = 0;
+        num_threads = strtol(argv[optind + 1], &end, 10);
+        if (errno || *end != '\0' || num_threads < 1 || num_threads > 1024) {
+            fprintf(stderr, "Error: threads must be 1-1024 (got '%s')\n", argv[optind + 1]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    static SamplerSpec spec, random_spec;
+    sampler_init(&spec, sampler, scramble, seed);
+    if (sampler != SAMPLER_RANDOM) {
+        printf("%s points%s:\n", sampler_name(&spec), scramble ? " (scrambled)" : "");
+    }
+    Estimate est, random;
+    double pi_approximation = approximate_pi(&spec, num_points, (int)num_threads, &est);
+    if (compare) {
+        printf("random points:\n");
+        sampler_init(&random_spec, SAMPLER_RANDOM, false, seed);
+        approximate_pi(&random_spec, num_points, (int)num_threads, &random);
+    }
+    if (sampler != SAMPLER_RANDOM) {
+        print_checkpoints(&spec, &est, compare ? &random : NULL);
+    }
     printf("Approximate value of Pi: %f\n", pi_approximation);
     return 0;
-}
\ No newline at end of file
+}
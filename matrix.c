@@ -1,5 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "graph.h"
+#include "apsp.h"
+#include "edge_io.h"
 
 // ANSI-Farben
 #define RED   "\033[1;31m"
@@ -7,42 +15,33 @@
 #define YELLOW "\033[1;33m"
 #define RESET "\033[0m"
 
-typedef struct {
-    int from;
-    int to;
-    int weight;
-} Edge;
-
-void fill_matrix(int** matrix, int size, Edge* edges, int edge_count) {
-    for (int i = 0; i < size; i++)
-        for (int j = 0; j < size; j++)
-            matrix[i][j] = 0;
-
-    for (int i = 0; i < edge_count; i++) {
-        int f = edges[i].from;
-        int t = edges[i].to;
-        int w = edges[i].weight;
-
-        if (f < 0 || f >= size || t < 0 || t >= size) {
-            printf(RED "Invalid edge: %d -> %d\n" RESET, f, t);
-            continue;
-        }
-
-        if (matrix[f][t] != 0) {
-            printf(YELLOW "Warning: Overwriting edge %d -> %d\n" RESET, f, t);
-        }
+// larger graphs are only summed up, not printed
+#define MAX_PRINT_NODES 32
+// the CSR build allocates a few arrays of this many entries up front
+#define MAX_NODES (1 << 24)
 
-        matrix[f][t] = w;
-        matrix[t][f] = -w;
+// builds the graph and sums up the skipped and overwritten edges
+bool fill_graph(GraphCSR *graph, int size, const Edge* edges, size_t edge_count) {
+    GraphBuildStats stats;
+    if (!graph_csr_build(graph, size, edges, edge_count, NULL, &stats)) {
+        return false;
     }
 
-    
+    if (stats.invalid > 0) {
+        const Edge *e = &edges[stats.first_invalid];
+        printf(RED "Invalid edges: %zu (first: %d -> %d)\n" RESET, stats.invalid, e->from, e->to);
+    }
+    if (stats.overwritten > 0) {
+        const Edge *e = &edges[stats.first_overwrite];
+        printf(YELLOW "Warning: %zu edges overwritten (first: %d -> %d)\n" RESET, stats.overwritten, e->from, e->to);
+    }
+    return true;
 }
 
-void print_matrix(int** matrix, int size) {
-    for (int i = 0; i < size; i++) {
-        for (int j = 0; j < size; j++) {
-            int val = matrix[i][j];
+void print_matrix(const GraphDense* matrix) {
+    for (int i = 0; i < matrix->num_nodes; i++) {
+        for (int j = 0; j < matrix->num_nodes; j++) {
+            int val = graph_dense_at(matrix, i, j);
 
             if (val > 0)
                 printf(BLUE "%4d" RESET, val);
@@ -55,7 +54,42 @@ void print_matrix(int** matrix, int size) {
     }
 }
 
-int main() {
+void print_distances(const int64_t* dist, int size) {
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            int64_t val = dist[(size_t)i * size + j];
+            if (val == APSP_INF)
+                printf("%6s", "-");
+            else
+                printf("%6lld", (long long)val);
+        }
+        printf("\n");
+    }
+}
+
+static double seconds_since(const struct timespec *t0) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec - t0->tv_sec) + (t.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static bool parse_positive(const char *arg, const char *name, long max, long *value) {
+    char *end;
+    errno = 0;
+    *value = strtol(arg, &end, 10);
+    if (errno || *end != '\0' || *value < 1 || *value > max) {
+        fprintf(stderr, "Error: %s must be 1-%ld (got '%s')\n", name, max, arg);
+        return false;
+    }
+    return true;
+}
+
+/* Usage: matrix [edge-file [nodes [threads]]]
+ * Without a file the example graph below is used; nodes defaults to the
+ * largest node in the file + 1, threads to the number of processors.
+ * nodes is at most MAX_NODES, edges to larger nodes count as invalid.
+ */
+int main(int argc, char *argv[]) {
     int size = 10;
 
     Edge edges[] = {
@@ -71,21 +105,70 @@ int main() {
         {9, 0, 18},
         {8, 3, 90}
     };
-    int edge_count = sizeof(edges) / sizeof(edges[0]);
-
-    // Matrix allokieren
-    int** matrix = malloc(size * sizeof(int*));
-    for (int i = 0; i < size; i++)
-        matrix[i] = malloc(size * sizeof(int));
+    const Edge* edge_list = edges;
+    size_t edge_count = sizeof(edges) / sizeof(edges[0]);
+
+    // Kanten aus einer Datei (Text oder binär)
+    EdgeList loaded = {0};
+    if (argc > 4) {
+        fprintf(stderr, "Usage: %s [edge-file [nodes (1-%d) [threads]]]\n", argv[0], MAX_NODES);
+        return 1;
+    }
+    if (argc > 1) {
+        long nodes = 0, threads = sysconf(_SC_NPROCESSORS_ONLN);
+        if (threads < 1) threads = 1;
+        if (argc > 2 && !parse_positive(argv[2], "nodes", MAX_NODES, &nodes)) return 1;
+        if (argc > 3 && !parse_positive(argv[3], "threads", 1024, &threads)) return 1;
+
+        struct timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (!edge_list_load(argv[1], (int)threads, &loaded)) {
+            return 1;
+        }
+        double seconds = seconds_since(&t0);
+        printf("Loaded %zu edges from %s (%.1f MB) in %.3f s, %.0f MB/s\n", loaded.count, argv[1],
+               loaded.bytes / 1e6, seconds, seconds > 0 ? loaded.bytes / 1e6 / seconds : 0.0);
+        if (loaded.malformed > 0) {
+            printf(RED "Malformed lines: %zu (first: line %zu)\n" RESET, loaded.malformed, loaded.first_malformed);
+        }
+        edge_list = loaded.edges;
+        edge_count = loaded.count;
+        size = nodes > 0 ? (int)nodes : (loaded.max_node < MAX_NODES ? loaded.max_node + 1 : MAX_NODES);
+    }
 
-    // Matrix füllen und drucken
-    fill_matrix(matrix, size, edges, edge_count);
-    print_matrix(matrix, size);
+    // Graph aufbauen (CSR), als Matrix drucken
+    GraphCSR graph;
+    GraphDense matrix;
+    bool built = fill_graph(&graph, size, edge_list, edge_count);
+    edge_list_free(&loaded);
+    if (!built) {
+        return 1;
+    }
+    if (size > MAX_PRINT_NODES) {
+        printf("Graph: %d nodes, %zu non-zero entries\n", size, graph.num_entries);
+        graph_csr_free(&graph);
+        return 0;
+    }
+    if (!graph_dense_from_csr(&matrix, &graph)) {
+        graph_csr_free(&graph);
+        return 1;
+    }
+    print_matrix(&matrix);
+
+    // Kürzeste Wege zwischen allen Knoten
+    int64_t* dist = malloc((size_t)size * size * sizeof(int64_t));
+    ApspStatus status = dist ? apsp_floyd_warshall(&matrix, 64, 1, dist) : APSP_NO_MEMORY;
+    if (status == APSP_NEGATIVE_CYCLE) {
+        printf(RED "Negative cycle: no shortest paths\n" RESET);
+    } else if (status == APSP_OK) {
+        printf("Shortest paths:\n");
+        print_distances(dist, size);
+    }
+    free(dist);
 
     // Speicher freigeben
-    for (int i = 0; i < size; i++)
-        free(matrix[i]);
-    free(matrix);
+    graph_dense_free(&matrix);
+    graph_csr_free(&graph);
 
     return 0;
 }